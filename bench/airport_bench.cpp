@@ -0,0 +1,51 @@
+// Airport LPs driven without the Time Warp kernel. See event_driver.hpp.
+
+#include <vector>
+
+#include "util/benchmark.h"
+#include "airport/airport.hpp"
+#include "event_driver.hpp"
+#include "state_bench.hpp"
+
+static const unsigned int kGridSize = 32;
+
+static unsigned int AirportEventType(const warped::Event& event) {
+    return static_cast<const AirportEvent&>(event).type_;
+}
+
+static void BM_Airport(int iters) {
+    StopBenchmarkTiming();
+    LPNameRegistry lp_names {"Airport_", kGridSize * kGridSize};
+    Torus2D grid {kGridSize, kGridSize};
+    std::vector<Airport> lps;
+    auto make_lps = [&]() {
+        lps.clear();
+        for (unsigned int i = 0; i < kGridSize * kGridSize; i++) {
+            lps.emplace_back(lp_names, grid, 50, 200, 50, 0, i);
+        }
+        std::vector<warped::LogicalProcess*> lp_pointers;
+        for (auto& lp : lps) {
+            lp_pointers.push_back(&lp);
+        }
+        return lp_pointers;
+    };
+    EventDriver driver {"airport", make_lps, {"ARRIVAL", "DEPARTURE"}, AirportEventType};
+
+    StartBenchmarkTiming();
+    driver.run(iters);
+    StopBenchmarkTiming();
+    driver.report();
+}
+BENCHMARK(BM_Airport)->ThreadRange(1, 1);
+
+static void BM_AirportStateSaveRestore(int iters) {
+    AirportState state {};
+    RunStateSaveRestore("BM_AirportStateSaveRestore", iters, state);
+}
+BENCHMARK(BM_AirportStateSaveRestore)->ThreadRange(1, 1);
+
+static void BM_AirportStateSerialize(int iters) {
+    AirportState state {};
+    RunStateSerialize("BM_AirportStateSerialize", iters, state);
+}
+BENCHMARK(BM_AirportStateSerialize)->ThreadRange(1, 1);
@@ -0,0 +1,86 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "alloc_counter.hpp"
+
+namespace {
+
+std::atomic<unsigned long long> num_allocs {0};
+std::atomic<unsigned long long> num_bytes {0};
+
+// Kept in static storage so that reporting never allocates itself
+struct AllocReport {
+    const char* name;
+    double allocs_per_op;
+    double bytes_per_op;
+};
+
+const unsigned int kMaxReports = 128;
+
+AllocReport reports[kMaxReports];
+unsigned int num_reports = 0;
+
+// Printed from a destructor so that the table follows the harness output
+struct AllocReporter {
+    ~AllocReporter() {
+        if (!num_reports) return;
+        std::printf("\n%-40s %12s %12s\n", "benchmark", "allocs/op", "bytes/op");
+        for (unsigned int i = 0; i < num_reports; i++) {
+            std::printf("%-40s %12.2f %12.1f\n", reports[i].name,
+                            reports[i].allocs_per_op, reports[i].bytes_per_op);
+        }
+    }
+} reporter;
+
+} // namespace
+
+AllocCounts CurrentAllocCounts() {
+    return AllocCounts {num_allocs.load(std::memory_order_relaxed),
+                            num_bytes.load(std::memory_order_relaxed)};
+}
+
+void ReportAllocations(const char* name, int iters, const AllocCounts& start) {
+    AllocCounts now = CurrentAllocCounts();
+    if (iters <= 0) return;
+
+    unsigned int i = 0;
+    while ((i < num_reports) && std::strcmp(reports[i].name, name)) i++;
+    if (i == kMaxReports) return;
+    if (i == num_reports) num_reports++;
+
+    reports[i] = AllocReport {name, (double)(now.allocs - start.allocs) / iters,
+                                    (double)(now.bytes - start.bytes) / iters};
+}
+
+void* operator new(std::size_t size) {
+    num_allocs.fetch_add(1, std::memory_order_relaxed);
+    num_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+// Compilers defaulting to C++14 or later call the sized forms
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
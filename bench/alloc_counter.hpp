@@ -0,0 +1,21 @@
+#ifndef WARPED_MODELS_BENCH_ALLOC_COUNTER_HPP
+#define WARPED_MODELS_BENCH_ALLOC_COUNTER_HPP
+
+// Process-wide heap allocation counters, fed by the replacement global
+// operator new in alloc_counter.cpp. Any benchmark program that links
+// alloc_counter.cpp gets every allocation counted.
+
+struct AllocCounts {
+    unsigned long long allocs;
+    unsigned long long bytes;
+};
+
+AllocCounts CurrentAllocCounts();
+
+// Records the allocations made since 'start' for a run of 'iters' operations of
+// the named benchmark. The harness calls each benchmark several times with a
+// growing iteration count; the last recorded run of every benchmark is printed
+// as allocs/op and bytes/op when the program exits.
+void ReportAllocations(const char* name, int iters, const AllocCounts& start);
+
+#endif
@@ -0,0 +1,68 @@
+// Epidemic locations driven without the Time Warp kernel. See
+// event_driver.hpp. The population is synthetic and every location links to
+// its nearest neighbours on a ring, like a Watts-Strogatz network with no
+// rewiring.
+
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "util/benchmark.h"
+#include "epidemic/epidemic.hpp"
+#include "event_driver.hpp"
+
+static const unsigned int kNumLocations = 256;
+static const unsigned int kPersonsPerLocation = 100;
+static const unsigned int kRingNeighbours = 4;
+
+static unsigned int EpidemicEventType(const warped::Event& event) {
+    return static_cast<const EpidemicEvent&>(event).event_type_;
+}
+
+static void BM_Epidemic(int iters) {
+    StopBenchmarkTiming();
+    LPNameRegistry location_names {"Location_", kNumLocations};
+    std::vector<Location> lps;
+    auto make_lps = [&]() {
+        // The same synthetic population every time
+        Philox4x32 rng;
+        std::uniform_real_distribution<double> susceptibility(0.0, 1.0);
+        std::uniform_int_distribution<int> infection_state(UNINFECTED, RECOVERED);
+
+        lps.clear();
+        for (unsigned int i = 0; i < kNumLocations; i++) {
+            std::vector<std::shared_ptr<Person>> population;
+            for (unsigned int j = 0; j < kPersonsPerLocation; j++) {
+                double person_susceptibility = susceptibility(rng);
+                auto state = (infection_state_t) infection_state(rng);
+                population.push_back(std::make_shared<Person>(i * kPersonsPerLocation + j,
+                                            person_susceptibility, j & 1, state, 0, 0));
+            }
+            lps.emplace_back(location_names[i], 0.12, 200, 100, 400, 200, 0, 0.3, 1, 0.5,
+                                0.2, 0.9, 0.5, 0.1, 0.3, 50, 100, population, 200, 0, i);
+        }
+        for (unsigned int i = 0; i < kNumLocations; i++) {
+            std::vector<std::pair<unsigned int, unsigned int>> travel_chart;
+            for (unsigned int k = 1; k <= kRingNeighbours / 2; k++) {
+                travel_chart.emplace_back((i + k) % kNumLocations, 200);
+                travel_chart.emplace_back((i + kNumLocations - k) % kNumLocations, 200);
+            }
+            lps[i].populateTravelDistances(location_names, travel_chart);
+        }
+        std::vector<warped::LogicalProcess*> lp_pointers;
+        for (auto& lp : lps) {
+            lp_pointers.push_back(&lp);
+        }
+        return lp_pointers;
+    };
+    EventDriver driver {"epidemic", make_lps, {"DISEASE_UPDATE_TRIGGER", "DIFFUSION_TRIGGER",
+                                                    "DIFFUSION"}, EpidemicEventType};
+
+    StartBenchmarkTiming();
+    driver.run(iters);
+    StopBenchmarkTiming();
+    driver.report();
+}
+BENCHMARK(BM_Epidemic)->ThreadRange(1, 1);
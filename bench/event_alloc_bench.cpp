@@ -0,0 +1,71 @@
+// Event allocation strategies behind make_event: raw new wrapped in a
+// shared_ptr, std::make_shared and std::allocate_shared from the per-thread
+// pools. Build with --with-tcmalloc to compare against tcmalloc as well.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "util/benchmark.h"
+#include "utility/memory.hpp"
+#include "alloc_counter.hpp"
+
+// Same shape as the model events: a vtable, a sender and a receiver name and
+// a few scalar fields
+struct BaseEvent {
+    virtual ~BaseEvent() {}
+    std::string sender_name_;
+    unsigned int generation_;
+};
+
+struct BenchEvent : public BaseEvent {
+    BenchEvent(unsigned int receiver, unsigned int timestamp)
+        : receiver_(receiver), timestamp_(timestamp) {}
+
+    unsigned int receiver_;
+    unsigned int timestamp_;
+    unsigned int payload_[4];
+};
+
+// Number of events kept alive at once, roughly a pending event set
+static const int kLiveEvents = 1024;
+
+template <typename Factory>
+static void RunEvents(const char* name, int iters, Factory factory) {
+    std::vector<std::shared_ptr<BaseEvent>> live(kLiveEvents);
+
+    AllocCounts start = CurrentAllocCounts();
+    for (int i = 0; i < iters; i++) {
+        live[i % kLiveEvents] = factory(i);
+    }
+    ReportAllocations(name, iters, start);
+}
+
+static void BM_EventNew(int iters) {
+    RunEvents("BM_EventNew", iters, [](unsigned int i) {
+        return std::shared_ptr<BenchEvent>(new BenchEvent(i, i));
+    });
+}
+BENCHMARK(BM_EventNew)->ThreadRange(1, 1);
+
+static void BM_EventMakeShared(int iters) {
+    RunEvents("BM_EventMakeShared", iters, [](unsigned int i) {
+        return std::make_shared<BenchEvent>(i, i);
+    });
+}
+BENCHMARK(BM_EventMakeShared)->ThreadRange(1, 1);
+
+static void BM_EventPool(int iters) {
+    RunEvents("BM_EventPool", iters, [](unsigned int i) {
+        return std::allocate_shared<BenchEvent>(PoolAllocator<BenchEvent>(), i, i);
+    });
+}
+BENCHMARK(BM_EventPool)->ThreadRange(1, 1);
+
+// Whatever --with-event-allocator selected
+static void BM_MakeEvent(int iters) {
+    RunEvents("BM_MakeEvent", iters, [](unsigned int i) {
+        return make_event<BenchEvent>(i, i);
+    });
+}
+BENCHMARK(BM_MakeEvent)->ThreadRange(1, 1);
@@ -0,0 +1,113 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "event_driver.hpp"
+#include "alloc_counter.hpp"
+
+namespace {
+
+// Kept in static storage like the allocation reports
+struct TypeReport {
+    const char* model;
+    const char* type;
+    unsigned long long events;
+    unsigned long long ns;
+    unsigned long long allocs;
+    unsigned long long bytes;
+};
+
+const unsigned int kMaxReports = 128;
+
+TypeReport reports[kMaxReports];
+unsigned int num_reports = 0;
+
+struct TypeReporter {
+    ~TypeReporter() {
+        if (!num_reports) return;
+        std::printf("\n%-32s %12s %14s %10s %12s %12s\n", "model/event type", "events",
+                        "events/sec", "ns/event", "allocs/event", "bytes/event");
+        for (unsigned int i = 0; i < num_reports; i++) {
+            const TypeReport& r = reports[i];
+            char name[64];
+            std::snprintf(name, sizeof name, "%s/%s", r.model, r.type);
+            double events = r.events ? (double) r.events : 1.0;
+            std::printf("%-32s %12llu %14.0f %10.1f %12.2f %12.1f\n", name, r.events,
+                            r.ns ? r.events * 1e9 / r.ns : 0.0, r.ns / events,
+                            r.allocs / events, r.bytes / events);
+        }
+    }
+} reporter;
+
+} // namespace
+
+EventDriver::EventDriver(const char* model, MakeLPs make_lps,
+                            std::vector<const char*> type_names, TypeOf type_of)
+    : model_(model), make_lps_(std::move(make_lps)), type_names_(std::move(type_names)),
+        type_of_(type_of), totals_(type_names_.size(), TypeTotals {0, 0, 0, 0}) {
+
+    initialize();
+}
+
+// Initializing the same LPs twice would register and seed their random
+// streams again, so every pass starts from newly built ones
+void EventDriver::initialize() {
+    lps_by_name_.clear();
+    lps_ = make_lps_();
+    for (auto lp : lps_) {
+        lps_by_name_.emplace(lp->name_, lp);
+    }
+    for (auto lp : lps_) {
+        auto events = lp->initializeLP();
+        schedule(events);
+    }
+}
+
+void EventDriver::schedule(std::vector<std::shared_ptr<warped::Event>>& events) {
+    for (auto& event : events) {
+        pending_.push(Pending {event->timestamp(), sequence_++, std::move(event)});
+    }
+}
+
+void EventDriver::run(int num_events) {
+    typedef std::chrono::steady_clock clock;
+
+    for (int i = 0; i < num_events; i++) {
+        if (pending_.empty()) {
+            initialize();
+            if (pending_.empty()) return;
+        }
+        std::shared_ptr<warped::Event> event = pending_.top().event_;
+        pending_.pop();
+        warped::LogicalProcess* lp = lps_by_name_.at(event->receiverName());
+
+        AllocCounts start_allocs = CurrentAllocCounts();
+        clock::time_point start = clock::now();
+        auto new_events = lp->receiveEvent(*event);
+        clock::time_point stop = clock::now();
+        AllocCounts stop_allocs = CurrentAllocCounts();
+
+        TypeTotals& totals = totals_[type_of_(*event)];
+        totals.events_++;
+        totals.ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+        totals.allocs_ += stop_allocs.allocs - start_allocs.allocs;
+        totals.bytes_ += stop_allocs.bytes - start_allocs.bytes;
+
+        schedule(new_events);
+    }
+}
+
+void EventDriver::report() const {
+    for (unsigned int type = 0; type < type_names_.size(); type++) {
+        unsigned int i = 0;
+        while ((i < num_reports) && (std::strcmp(reports[i].model, model_) ||
+                                        std::strcmp(reports[i].type, type_names_[type]))) i++;
+        if (i == kMaxReports) return;
+        if (i == num_reports) num_reports++;
+
+        const TypeTotals& totals = totals_[type];
+        reports[i] = TypeReport {model_, type_names_[type], totals.events_, totals.ns_,
+                                    totals.allocs_, totals.bytes_};
+    }
+}
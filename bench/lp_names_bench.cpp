@@ -0,0 +1,55 @@
+// Destination name lookup: per-event string building versus the interned
+// LPNameRegistry. Run with a regexp argument to select benchmarks.
+
+#include <string>
+
+#include "util/benchmark.h"
+#include "utility/lp_names.hpp"
+#include "alloc_counter.hpp"
+
+static const unsigned int kNumLPs = 10000;
+
+// Long enough to defeat the small string optimisation, as in the traffic model
+static const char kPrefix[] = "Intersection_";
+
+static volatile char sink;
+
+// What the models used to do: build the name on every event
+static void BM_ConcatName(int iters) {
+    AllocCounts start = CurrentAllocCounts();
+    for (int i = 0; i < iters; i++) {
+        std::string name = std::string(kPrefix) + std::to_string(i % kNumLPs);
+        sink = name.back();
+    }
+    ReportAllocations("BM_ConcatName", iters, start);
+}
+BENCHMARK(BM_ConcatName)->ThreadRange(1, 1);
+
+static void BM_RegistryName(int iters) {
+    StopBenchmarkTiming();
+    LPNameRegistry names {kPrefix, kNumLPs};
+    StartBenchmarkTiming();
+
+    AllocCounts start = CurrentAllocCounts();
+    for (int i = 0; i < iters; i++) {
+        const std::string& name = names[i % kNumLPs];
+        sink = name.back();
+    }
+    ReportAllocations("BM_RegistryName", iters, start);
+}
+BENCHMARK(BM_RegistryName)->ThreadRange(1, 1);
+
+// Events still own a copy of their receiver name; this includes that copy
+static void BM_RegistryNameCopy(int iters) {
+    StopBenchmarkTiming();
+    LPNameRegistry names {kPrefix, kNumLPs};
+    StartBenchmarkTiming();
+
+    AllocCounts start = CurrentAllocCounts();
+    for (int i = 0; i < iters; i++) {
+        std::string receiver_name { names[i % kNumLPs] };
+        sink = receiver_name.back();
+    }
+    ReportAllocations("BM_RegistryNameCopy", iters, start);
+}
+BENCHMARK(BM_RegistryNameCopy)->ThreadRange(1, 1);
@@ -0,0 +1,52 @@
+// PCS cells driven without the Time Warp kernel. See event_driver.hpp.
+
+#include <vector>
+
+#include "util/benchmark.h"
+#include "pcs/pcs.hpp"
+#include "event_driver.hpp"
+#include "state_bench.hpp"
+
+static const unsigned int kGridSize = 32;
+
+static unsigned int PcsEventType(const warped::Event& event) {
+    return static_cast<const PcsEvent&>(event).method_;
+}
+
+static void BM_Pcs(int iters) {
+    StopBenchmarkTiming();
+    LPNameRegistry lp_names {"Cell_", kGridSize * kGridSize};
+    Torus2D grid {kGridSize, kGridSize};
+    std::vector<PcsCell> lps;
+    auto make_lps = [&]() {
+        lps.clear();
+        for (unsigned int i = 0; i < kGridSize * kGridSize; i++) {
+            lps.emplace_back(lp_names, grid, 15, 200, 50, 100, 50, 0, i);
+        }
+        std::vector<warped::LogicalProcess*> lp_pointers;
+        for (auto& lp : lps) {
+            lp_pointers.push_back(&lp);
+        }
+        return lp_pointers;
+    };
+    EventDriver driver {"pcs", make_lps, {"NEXT_CALL", "COMPLETE_CALL", "MOVE_CALL_IN",
+                                                "MOVE_CALL_OUT"}, PcsEventType};
+
+    StartBenchmarkTiming();
+    driver.run(iters);
+    StopBenchmarkTiming();
+    driver.report();
+}
+BENCHMARK(BM_Pcs)->ThreadRange(1, 1);
+
+static void BM_PcsStateSaveRestore(int iters) {
+    PcsState state {};
+    RunStateSaveRestore("BM_PcsStateSaveRestore", iters, state);
+}
+BENCHMARK(BM_PcsStateSaveRestore)->ThreadRange(1, 1);
+
+static void BM_PcsStateSerialize(int iters) {
+    PcsState state {};
+    RunStateSerialize("BM_PcsStateSerialize", iters, state);
+}
+BENCHMARK(BM_PcsStateSerialize)->ThreadRange(1, 1);
@@ -0,0 +1,68 @@
+// PHOLD LPs driven without the Time Warp kernel, one benchmark per delay
+// distribution. See event_driver.hpp.
+
+#include <memory>
+#include <vector>
+
+#include "util/benchmark.h"
+#include "phold/phold.hpp"
+#include "utility/lp_array.hpp"
+#include "event_driver.hpp"
+#include "state_bench.hpp"
+
+static const unsigned int kNumLPs = 1024;
+static const unsigned int kInitialEvents = 4;
+
+static unsigned int PholdEventType(const warped::Event&) {
+    return 0;
+}
+
+static void RunPhold(const char* name, int iters, distribution_t distribution) {
+    StopBenchmarkTiming();
+    LPNameRegistry lp_names {"LP ", kNumLPs};
+    PholdRun run {lp_names, kInitialEvents, 0, distribution, 10.0};
+    std::unique_ptr<LPArray<PholdLP>> lps;
+    auto make_lps = [&]() {
+        lps.reset();
+        lps.reset(new LPArray<PholdLP>(kNumLPs, run));
+        return lps->pointers<warped::LogicalProcess>();
+    };
+    EventDriver driver {name, make_lps, {"PholdEvent"}, PholdEventType};
+
+    StartBenchmarkTiming();
+    driver.run(iters);
+    StopBenchmarkTiming();
+    driver.report();
+}
+
+static void BM_PholdExponential(int iters) {
+    RunPhold("phold_exponential", iters, EXPONENTIAL);
+}
+BENCHMARK(BM_PholdExponential)->ThreadRange(1, 1);
+
+static void BM_PholdUniform(int iters) {
+    RunPhold("phold_uniform", iters, UNIFORM);
+}
+BENCHMARK(BM_PholdUniform)->ThreadRange(1, 1);
+
+static void BM_PholdNormal(int iters) {
+    RunPhold("phold_normal", iters, NORMAL);
+}
+BENCHMARK(BM_PholdNormal)->ThreadRange(1, 1);
+
+static void BM_PholdPoisson(int iters) {
+    RunPhold("phold_poisson", iters, POISSON);
+}
+BENCHMARK(BM_PholdPoisson)->ThreadRange(1, 1);
+
+static void BM_PholdStateSaveRestore(int iters) {
+    PholdState state {};
+    RunStateSaveRestore("BM_PholdStateSaveRestore", iters, state);
+}
+BENCHMARK(BM_PholdStateSaveRestore)->ThreadRange(1, 1);
+
+static void BM_PholdStateSerialize(int iters) {
+    PholdState state {};
+    RunStateSerialize("BM_PholdStateSerialize", iters, state);
+}
+BENCHMARK(BM_PholdStateSerialize)->ThreadRange(1, 1);
@@ -0,0 +1,68 @@
+// Memory and startup time of PHOLD LPs at scale: builds the LPs of a run as
+// phold_sim does, for each number of LPs given, and reports the resident
+// bytes per LP and the time to build them.
+//
+//   phold_scale 1000000 10000000 100000000
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "phold/phold.hpp"
+#include "utility/lp_array.hpp"
+
+// Resident set size in bytes
+static long ResidentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+static void Measure(unsigned int num_lps) {
+    typedef std::chrono::steady_clock clock;
+
+    long start_bytes = ResidentBytes();
+    clock::time_point start = clock::now();
+
+    LPNameRegistry lp_names {"LP ", num_lps};
+    clock::time_point names_done = clock::now();
+    PholdRun run {lp_names, 1, 0, EXPONENTIAL, 10.0};
+    LPArray<PholdLP> lps {num_lps, run};
+    std::vector<warped::LogicalProcess*> lp_pointers = lps.pointers<warped::LogicalProcess>();
+    clock::time_point done = clock::now();
+
+    double bytes = (double) (ResidentBytes() - start_bytes) / num_lps;
+    auto seconds = [](clock::duration d) { return std::chrono::duration<double>(d).count(); };
+    std::printf("%12u %10.1f %10zu %10.3f %10.3f %10.3f\n", num_lps, bytes, sizeof(PholdLP),
+                    seconds(names_done - start), seconds(done - names_done), 
+                    seconds(done - start));
+    std::fflush(stdout);
+}
+
+int main(int argc, const char** argv) {
+    std::vector<unsigned int> sizes;
+    for (int i = 1; i < argc; i++) {
+        sizes.push_back(std::stoul(argv[i]));
+    }
+    if (sizes.empty()) {
+        sizes = {1000000, 10000000, 100000000};
+    }
+
+    std::printf("%12s %10s %10s %10s %10s %10s\n", "LPs", "bytes/LP", "sizeof LP", "names s", 
+                    "LPs s", "startup s");
+    for (auto num_lps : sizes) {
+        try {
+            Measure(num_lps);
+        } catch (const std::bad_alloc&) {
+            std::cerr << "Out of memory at " << num_lps << " LPs" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
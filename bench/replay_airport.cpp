@@ -0,0 +1,32 @@
+#include <string>
+#include <vector>
+
+#include "airport/airport.hpp"
+#include "trace_replayer.hpp"
+
+bool ReplayAirport(TraceReader& trace, unsigned int passes) {
+    unsigned int num_airports_x = std::stoul(trace.param("num-airports-x", "50"));
+    unsigned int num_airports_y = std::stoul(trace.param("num-airports-y", "50"));
+    unsigned int mean_ground_time = std::stoul(trace.param("ground-time", "50"));
+    unsigned int mean_flight_time = std::stoul(trace.param("flight-time", "200"));
+    unsigned int num_planes = std::stoul(trace.param("num-planes", "50"));
+    std::uint64_t seed = std::stoull(trace.param("seed", "0"));
+
+    LPNameRegistry lp_names {"Airport_", num_airports_x * num_airports_y};
+    Torus2D grid {num_airports_x, num_airports_y};
+    TraceReplayer replayer {trace, {"ARRIVAL", "DEPARTURE"}};
+    for (unsigned int pass = 1; pass <= passes; pass++) {
+        std::vector<Airport> lps;
+        for (unsigned int i = 0; i < num_airports_x * num_airports_y; i++) {
+            lps.emplace_back(lp_names, grid, num_planes, mean_flight_time, mean_ground_time,
+                                                                                    seed, i);
+        }
+        std::vector<warped::LogicalProcess*> lp_pointers;
+        for (auto& lp : lps) {
+            lp_pointers.push_back(&lp);
+        }
+        if (!replayer.run<AirportEvent>(lp_pointers)) return false;
+        replayer.report(pass);
+    }
+    return true;
+}
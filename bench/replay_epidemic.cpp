@@ -0,0 +1,30 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "epidemic/epidemic.hpp"
+#include "trace_replayer.hpp"
+
+bool ReplayEpidemic(TraceReader& trace, unsigned int passes) {
+    std::string config_filename = trace.param("model", "model_25k.dat");
+    std::uint64_t seed = std::stoull(trace.param("seed", "0"));
+
+    TraceReplayer replayer {trace, {"DISEASE_UPDATE_TRIGGER", "DIFFUSION_TRIGGER",
+                                                                        "DIFFUSION"}};
+    for (unsigned int pass = 1; pass <= passes; pass++) {
+        std::vector<Location> lps;
+        std::unique_ptr<LPNameRegistry> location_names;
+        if (!loadLocations(config_filename, seed, lps, location_names)) {
+            std::cerr << "Invalid configuration file - " << config_filename << std::endl;
+            return false;
+        }
+        std::vector<warped::LogicalProcess*> lp_pointers;
+        for (auto& lp : lps) {
+            lp_pointers.push_back(&lp);
+        }
+        if (!replayer.run<EpidemicEvent>(lp_pointers)) return false;
+        replayer.report(pass);
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#include <string>
+#include <vector>
+
+#include "pcs/pcs.hpp"
+#include "trace_replayer.hpp"
+
+bool ReplayPcs(TraceReader& trace, unsigned int passes) {
+    unsigned int num_cells_x = std::stoul(trace.param("num-cells-x", "100"));
+    unsigned int num_cells_y = std::stoul(trace.param("num-cells-y", "100"));
+    unsigned int max_channel_cnt = std::stoul(trace.param("channel-cnt", "15"));
+    unsigned int call_interval_mean = std::stoul(trace.param("call-interval", "200"));
+    unsigned int call_duration_mean = std::stoul(trace.param("call-duration", "50"));
+    unsigned int move_interval_mean = std::stoul(trace.param("move-interval", "100"));
+    unsigned int num_portables = std::stoul(trace.param("portable-count", "50"));
+    std::uint64_t seed = std::stoull(trace.param("seed", "0"));
+
+    LPNameRegistry lp_names {"Cell_", num_cells_x * num_cells_y};
+    Torus2D grid {num_cells_x, num_cells_y};
+    TraceReplayer replayer {trace, {"NEXT_CALL", "COMPLETE_CALL", "MOVE_CALL_IN",
+                                                                    "MOVE_CALL_OUT"}};
+    for (unsigned int pass = 1; pass <= passes; pass++) {
+        std::vector<PcsCell> lps;
+        for (unsigned int i = 0; i < num_cells_x * num_cells_y; i++) {
+            lps.emplace_back(lp_names, grid, max_channel_cnt, call_interval_mean,
+                        call_duration_mean, move_interval_mean, num_portables, seed, i);
+        }
+        std::vector<warped::LogicalProcess*> lp_pointers;
+        for (auto& lp : lps) {
+            lp_pointers.push_back(&lp);
+        }
+        if (!replayer.run<PcsEvent>(lp_pointers)) return false;
+        replayer.report(pass);
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "phold/phold.hpp"
+#include "utility/lp_array.hpp"
+#include "trace_replayer.hpp"
+
+bool ReplayPhold(TraceReader& trace, unsigned int passes) {
+    unsigned int num_lps = std::stoul(trace.param("num_lps", "10000"));
+    unsigned int num_initial_events = std::stoul(trace.param("events", "1"));
+    double distribution_mean = std::stod(trace.param("mean", "10.0"));
+    std::uint64_t seed = std::stoull(trace.param("seed", "0"));
+
+    // Index of a distribution name in kDistributionNames, or ALL + 1
+    auto lookup = [](const std::string& name) {
+        unsigned int dist = 0;
+        while ((dist <= ALL) && std::strcmp(kDistributionNames[dist], name.c_str())) dist++;
+        return dist;
+    };
+
+    PholdConfig config;
+    config.self_fraction_ = std::stod(trace.param("self-fraction", "0"));
+    config.local_fraction_ = std::stod(trace.param("local-fraction", "0"));
+    config.neighbourhood_ = std::stoul(trace.param("neighbourhood", "1"));
+    config.zipf_destinations_ = (trace.param("destination", "UNIFORM") == "ZIPF");
+    config.zipf_exponent_ = std::stod(trace.param("zipf-exponent", "1"));
+    config.hot_set_period_ = std::stoul(trace.param("hot-set-period", "0"));
+    config.hot_set_shift_ = std::stoul(trace.param("hot-set-shift", "0"));
+    config.event_grain_flops_ = std::stoull(trace.param("event-grain", "0"));
+    config.state_bytes_ = std::stoul(trace.param("state-bytes", "0"));
+    config.state_modified_fraction_ = std::stod(trace.param("state-modified", "1"));
+    config.lookahead_ = std::stoul(trace.param("lookahead", "0"));
+    config.fanout_ = std::stoul(trace.param("fanout", "2"));
+    config.fanout_probability_ = std::stod(trace.param("fanout-probability", "0"));
+    config.population_target_ = std::stoull(trace.param("population-target", "0"));
+    config.payload_bytes_ = std::stoul(trace.param("payload-bytes", "0"));
+    unsigned int grain_dist = lookup(trace.param("grain-distribution", "FIXED"));
+    if (grain_dist > ALL) return false;
+    config.grain_distribution_ = (distribution_t) grain_dist;
+
+    unsigned int dist = lookup(trace.param("distribution", "EXPONENTIAL"));
+    if (dist > ALL) return false;
+
+    // The phase count guards against replaying a schedule that lost phases
+    // on the way, which would still replay, only with the wrong workload
+    std::string phase_error;
+    if (!parsePholdPhases(trace.param("phases"), (distribution_t) dist, distribution_mean, 
+                                                    config, config.phases_, phase_error)) {
+        std::cerr << "Invalid phase schedule in trace: " << phase_error << std::endl;
+        return false;
+    }
+    std::string phase_count = trace.param("phase-count", std::to_string(config.phases_.size()));
+    if (std::stoul(phase_count) != config.phases_.size()) {
+        std::cerr << "Trace has " << phase_count << " phases but its schedule parses to " 
+                                                << config.phases_.size() << std::endl;
+        return false;
+    }
+
+    LPNameRegistry lp_names {"LP ", num_lps};
+    PholdRun run {lp_names, num_initial_events, seed, (distribution_t) dist, distribution_mean, 
+                                                                                    config};
+    TraceReplayer replayer {trace, {"PholdEvent"}};
+    for (unsigned int pass = 1; pass <= passes; pass++) {
+        LPArray<PholdLP> lps {num_lps, run};
+        if (!replayer.run<PholdEvent>(lps.pointers<warped::LogicalProcess>())) return false;
+        replayer.report(pass);
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "traffic/traffic.hpp"
+#include "trace_replayer.hpp"
+
+bool ReplayTraffic(TraceReader& trace, unsigned int passes) {
+    unsigned int num_intersections_x = std::stoul(trace.param("num-intersections-x", "100"));
+    unsigned int num_intersections_y = std::stoul(trace.param("num-intersections-y", "100"));
+    unsigned int num_cars = std::stoul(trace.param("number-of-cars", "25"));
+    unsigned int mean_interval = std::stoul(trace.param("mean-interval", "400"));
+    unsigned int trip_bucket_width = std::stoul(trace.param("trip-bucket", "10000"));
+    std::uint64_t seed = std::stoull(trace.param("seed", "0"));
+    std::string network_filename = trace.param("road-network");
+    TrafficSignalPlan signals;
+    if (!parseSignalTimings(trace.param("signal-timings"), signals)) return false;
+    signals.offset_ = std::stoul(trace.param("signal-offset", "0"));
+
+    RoadNetwork network;
+    if (network_filename.empty()) {
+        Torus2D grid {num_intersections_x, num_intersections_y};
+        network = RoadNetwork::fromGrid(grid, 0, kGridRoadCapacity);
+    } else if (!network.open(network_filename)) {
+        std::cerr << "Invalid road network file - " << network_filename << std::endl;
+        return false;
+    }
+
+    TrafficDemand demand;
+    std::string od_matrix_filename = trace.param("od-matrix");
+    std::string demand_error;
+    if ((!od_matrix_filename.empty() && !demand.loadMatrix(od_matrix_filename, 
+                            num_intersections_x, num_intersections_y, demand_error)) || 
+                !demand.setProfile(trace.param("demand-profile"), 
+                            std::stoul(trace.param("day-length", "86400")), demand_error)) {
+        std::cerr << "Invalid demand: " << demand_error << std::endl;
+        return false;
+    }
+
+    LPNameRegistry lp_names {"Intersection_", network.numNodes()};
+    TraceReplayer replayer {trace, 
+                    {"ARRIVAL", "DEPARTURE", "DIRECTION_SELECT", "SIGNAL", "SOURCE"}};
+    for (unsigned int pass = 1; pass <= passes; pass++) {
+        std::vector<Intersection> lps;
+        for (unsigned int i = 0; i < network.numNodes(); i++) {
+            lps.emplace_back(lp_names, network, signals, demand, num_cars, mean_interval, trip_bucket_width, seed, i);
+        }
+        std::vector<warped::LogicalProcess*> lp_pointers;
+        for (auto& lp : lps) {
+            lp_pointers.push_back(&lp);
+        }
+        if (!replayer.run<TrafficEvent>(lp_pointers)) return false;
+        replayer.report(pass);
+    }
+    return true;
+}
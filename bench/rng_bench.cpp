@@ -0,0 +1,89 @@
+// Random engine costs seen by the kernel and the models: saving and restoring
+// the engine state through the stream operators, as registerRNG does around
+// every event, and drawing numbers.
+
+#include <cstdint>
+#include <random>
+#include <sstream>
+
+#include "util/benchmark.h"
+#include "utility/philox.hpp"
+#include "alloc_counter.hpp"
+
+static volatile std::uint32_t sink;
+
+template <typename Engine>
+static void SaveRestore(const char* name, int iters) {
+    Engine rng;
+    std::stringstream stream;
+
+    AllocCounts start = CurrentAllocCounts();
+    for (int i = 0; i < iters; i++) {
+        stream.str("");
+        stream.clear();
+        stream << rng;
+        sink = rng();
+        stream >> rng;
+    }
+    ReportAllocations(name, iters, start);
+}
+
+template <typename Engine>
+static void Generate(int iters) {
+    Engine rng;
+    for (int i = 0; i < iters; i++) {
+        sink = rng();
+    }
+}
+
+static void BM_SaveRestoreDefaultEngine(int iters) {
+    SaveRestore<std::default_random_engine>("BM_SaveRestoreDefaultEngine", iters);
+}
+BENCHMARK(BM_SaveRestoreDefaultEngine)->ThreadRange(1, 1);
+
+static void BM_SaveRestoreMt19937(int iters) {
+    SaveRestore<std::mt19937>("BM_SaveRestoreMt19937", iters);
+}
+BENCHMARK(BM_SaveRestoreMt19937)->ThreadRange(1, 1);
+
+static void BM_SaveRestorePhilox(int iters) {
+    SaveRestore<Philox4x32>("BM_SaveRestorePhilox", iters);
+}
+BENCHMARK(BM_SaveRestorePhilox)->ThreadRange(1, 1);
+
+// The full Philox state is a handful of words, so a plain copy also works
+static void BM_CopyPhilox(int iters) {
+    Philox4x32 rng;
+    Philox4x32 saved;
+    for (int i = 0; i < iters; i++) {
+        saved = rng;
+        sink = rng();
+        rng = saved;
+    }
+}
+BENCHMARK(BM_CopyPhilox)->ThreadRange(1, 1);
+
+// Jumping straight to an arbitrary point of the stream
+static void BM_SeekPhilox(int iters) {
+    Philox4x32 rng;
+    for (int i = 0; i < iters; i++) {
+        rng.seek((std::uint64_t)i * 1000003);
+        sink = rng();
+    }
+}
+BENCHMARK(BM_SeekPhilox)->ThreadRange(1, 1);
+
+static void BM_GenerateDefaultEngine(int iters) {
+    Generate<std::default_random_engine>(iters);
+}
+BENCHMARK(BM_GenerateDefaultEngine)->ThreadRange(1, 1);
+
+static void BM_GenerateMt19937(int iters) {
+    Generate<std::mt19937>(iters);
+}
+BENCHMARK(BM_GenerateMt19937)->ThreadRange(1, 1);
+
+static void BM_GeneratePhilox(int iters) {
+    Generate<Philox4x32>(iters);
+}
+BENCHMARK(BM_GeneratePhilox)->ThreadRange(1, 1);
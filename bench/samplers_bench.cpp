@@ -0,0 +1,88 @@
+// Delay samplers from utility/samplers.hpp against the <random> distributions
+// they replace. The <random> baselines construct the distribution for every
+// draw, as the models used to on every event. All draws come from Philox.
+
+#include <random>
+
+#include "util/benchmark.h"
+#include "utility/philox.hpp"
+#include "utility/samplers.hpp"
+
+static volatile double sink;
+
+template <typename Sampler>
+static void Sample(int iters, const Sampler& sampler) {
+    Philox4x32 rng;
+    for (int i = 0; i < iters; i++) {
+        sink = sampler(rng);
+    }
+}
+
+template <typename Distribution, typename ...Params>
+static void SampleStd(int iters, Params... params) {
+    Philox4x32 rng;
+    for (int i = 0; i < iters; i++) {
+        Distribution distribution(params...);
+        sink = distribution(rng);
+    }
+}
+
+static void BM_ExponentialStd(int iters) {
+    SampleStd<std::exponential_distribution<double>>(iters, 1.0/200);
+}
+BENCHMARK(BM_ExponentialStd)->ThreadRange(1, 1);
+
+static void BM_ExponentialZiggurat(int iters) {
+    Sample(iters, ExponentialSampler(200));
+}
+BENCHMARK(BM_ExponentialZiggurat)->ThreadRange(1, 1);
+
+static void BM_NormalStd(int iters) {
+    SampleStd<std::normal_distribution<double>>(iters, 10.0, 1.0);
+}
+BENCHMARK(BM_NormalStd)->ThreadRange(1, 1);
+
+static void BM_NormalZiggurat(int iters) {
+    Sample(iters, NormalSampler(10.0, 1.0));
+}
+BENCHMARK(BM_NormalZiggurat)->ThreadRange(1, 1);
+
+static void BM_Poisson10Std(int iters) {
+    SampleStd<std::poisson_distribution<unsigned int>>(iters, 10);
+}
+BENCHMARK(BM_Poisson10Std)->ThreadRange(1, 1);
+
+static void BM_Poisson10Table(int iters) {
+    Sample(iters, PoissonSampler(10));
+}
+BENCHMARK(BM_Poisson10Table)->ThreadRange(1, 1);
+
+static void BM_Poisson200Std(int iters) {
+    SampleStd<std::poisson_distribution<unsigned int>>(iters, 200);
+}
+BENCHMARK(BM_Poisson200Std)->ThreadRange(1, 1);
+
+static void BM_Poisson200Table(int iters) {
+    Sample(iters, PoissonSampler(200));
+}
+BENCHMARK(BM_Poisson200Table)->ThreadRange(1, 1);
+
+static void BM_UniformIntStd(int iters) {
+    SampleStd<std::uniform_int_distribution<int>>(iters, 0, 9999);
+}
+BENCHMARK(BM_UniformIntStd)->ThreadRange(1, 1);
+
+static void BM_UniformIntLemire(int iters) {
+    Sample(iters, UniformIntSampler(0, 9999));
+}
+BENCHMARK(BM_UniformIntLemire)->ThreadRange(1, 1);
+
+static void BM_UniformRealStd(int iters) {
+    SampleStd<std::uniform_real_distribution<double>>(iters, 0.0, 1.0);
+}
+BENCHMARK(BM_UniformRealStd)->ThreadRange(1, 1);
+
+static void BM_UniformReal(int iters) {
+    Sample(iters, UniformRealSampler(0.0, 1.0));
+}
+BENCHMARK(BM_UniformReal)->ThreadRange(1, 1);
@@ -0,0 +1,40 @@
+#ifndef WARPED_MODELS_BENCH_STATE_BENCH_HPP
+#define WARPED_MODELS_BENCH_STATE_BENCH_HPP
+
+#include <memory>
+#include <sstream>
+
+#include "warped.hpp"
+#include "cereal/archives/binary.hpp"
+#include "alloc_counter.hpp"
+
+// What the kernel pays for a state on every processed event: a clone() to save
+// it, and a restoreState() from the saved copy on rollback
+template <typename State>
+void RunStateSaveRestore(const char* name, int iters, State& state) {
+    AllocCounts start = CurrentAllocCounts();
+    for (int i = 0; i < iters; i++) {
+        std::unique_ptr<warped::LPState> saved = state.clone();
+        state.restoreState(*saved);
+    }
+    ReportAllocations(name, iters, start);
+}
+
+// A checkpoint of the state through a binary archive and back
+template <typename State>
+void RunStateSerialize(const char* name, int iters, State& state) {
+    std::stringstream stream;
+    cereal::BinaryOutputArchive output_archive(stream);
+    cereal::BinaryInputArchive input_archive(stream);
+
+    AllocCounts start = CurrentAllocCounts();
+    for (int i = 0; i < iters; i++) {
+        stream.seekp(0);
+        stream.seekg(0);
+        state.save(output_archive);
+        state.load(input_archive);
+    }
+    ReportAllocations(name, iters, start);
+}
+
+#endif
@@ -0,0 +1,70 @@
+// Replays an event trace recorded with a model's --trace option through the
+// model's LPs, without the Time Warp kernel. See trace_replayer.hpp.
+//
+//   trace_replay epidemic.trace 5
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "trace_replayer.hpp"
+
+void TraceReplayer::report(unsigned int pass) const {
+    unsigned long long events = 0;
+    for (auto& totals : totals_) {
+        events += totals.events_;
+    }
+    std::printf("\npass %u: %llu events in %.3f s, %.0f events/sec\n", pass, events,
+                    pass_ns_ / 1e9, pass_ns_ ? events * 1e9 / pass_ns_ : 0.0);
+    std::printf("%-24s %12s %10s %12s %12s %10s\n", "event type", "events", "ns/event",
+                    "allocs/event", "bytes/event", "fan-out");
+    for (unsigned int type = 0; type < type_names_.size(); type++) {
+        const TypeTotals& t = totals_[type];
+        double n = t.events_ ? (double) t.events_ : 1.0;
+        std::printf("%-24s %12llu %10.1f %12.2f %12.1f %10.2f\n", type_names_[type], t.events_,
+                        t.ns_ / n, t.allocs_ / n, t.bytes_ / n, t.sent_ / n);
+    }
+}
+
+int main(int argc, const char** argv) {
+
+    if ((argc < 2) || (argc > 3)) {
+        std::cerr << "Usage: " << argv[0] << " <trace file> [passes]" << std::endl;
+        return 1;
+    }
+    unsigned int passes = (argc == 3) ? std::stoul(argv[2]) : 1;
+
+    TraceReader trace;
+    if (!trace.open(argv[1])) {
+        std::cerr << "Invalid or unfinished trace file - " << argv[1] << std::endl;
+        return 1;
+    }
+    std::printf("%s trace, %llu events\n", trace.model().c_str(),
+                    (unsigned long long) trace.numRecords());
+    for (auto& param : trace.params()) {
+        std::printf("  %s = %s\n", param.first.c_str(), param.second.c_str());
+    }
+
+    bool matched;
+    const std::string& model = trace.model();
+    if (model == "phold") {
+        matched = ReplayPhold(trace, passes);
+    } else if (model == "airport") {
+        matched = ReplayAirport(trace, passes);
+    } else if (model == "pcs") {
+        matched = ReplayPcs(trace, passes);
+    } else if (model == "traffic") {
+        matched = ReplayTraffic(trace, passes);
+    } else if (model == "epidemic") {
+        matched = ReplayEpidemic(trace, passes);
+    } else {
+        std::cerr << "Unknown model - " << model << std::endl;
+        return 1;
+    }
+    if (!matched) {
+        std::cerr << "The trace does not match the " << model << " model" << std::endl;
+        return 1;
+    }
+    return 0;
+}
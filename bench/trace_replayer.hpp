@@ -0,0 +1,93 @@
+#ifndef WARPED_MODELS_BENCH_TRACE_REPLAYER_HPP
+#define WARPED_MODELS_BENCH_TRACE_REPLAYER_HPP
+
+#include <chrono>
+#include <vector>
+
+#include "warped.hpp"
+#include "utility/trace.hpp"
+#include "alloc_counter.hpp"
+
+// Feeds the records of a trace (see deps/utility/trace.hpp) to the
+// receiveEvent() of the LPs that processed them, in trace order, without the
+// Time Warp kernel. The events an LP sends in response are counted as its
+// fan-out and dropped, since the trace already holds every event that was
+// processed. Given LPs freshly built with the trace's parameters, every pass
+// makes exactly the same calls.
+//
+// As in EventDriver, every receiveEvent() call is timed and its heap
+// allocations counted, per event type.
+class TraceReplayer {
+public:
+    TraceReplayer(TraceReader& trace, std::vector<const char*> type_names)
+        : trace_(trace), type_names_(std::move(type_names)) {}
+
+    // One pass over the whole trace. Returns false if a record names an LP or
+    // an event type that the model does not have.
+    template <typename EventType>
+    bool run(const std::vector<warped::LogicalProcess*>& lps) {
+        typedef std::chrono::steady_clock clock;
+
+        totals_.assign(type_names_.size(), TypeTotals {0, 0, 0, 0, 0});
+        for (auto lp : lps) {
+            lp->initializeLP();
+        }
+
+        EventType event;
+        TraceRecord record;
+        trace_.rewind();
+        clock::time_point pass_start = clock::now();
+        while (trace_.next(record)) {
+            if ((record.receiver_ >= lps.size()) || (record.type_ >= type_names_.size())) {
+                return false;
+            }
+            trace_.decode(record, event);
+            warped::LogicalProcess* lp = lps[record.receiver_];
+
+            AllocCounts start_allocs = CurrentAllocCounts();
+            clock::time_point start = clock::now();
+            auto new_events = lp->receiveEvent(event);
+            clock::time_point stop = clock::now();
+            AllocCounts stop_allocs = CurrentAllocCounts();
+
+            TypeTotals& totals = totals_[record.type_];
+            totals.events_++;
+            totals.ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+            totals.allocs_ += stop_allocs.allocs - start_allocs.allocs;
+            totals.bytes_ += stop_allocs.bytes - start_allocs.bytes;
+            totals.sent_ += new_events.size();
+        }
+        pass_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                    clock::now() - pass_start).count();
+        return true;
+    }
+
+    // Prints the wall time of the last pass, including decoding, and its
+    // per-type totals
+    void report(unsigned int pass) const;
+
+private:
+    struct TypeTotals {
+        unsigned long long events_;
+        unsigned long long ns_;
+        unsigned long long allocs_;
+        unsigned long long bytes_;
+        unsigned long long sent_;
+    };
+
+    TraceReader& trace_;
+    std::vector<const char*> type_names_;
+    std::vector<TypeTotals> totals_;
+    unsigned long long pass_ns_ = 0;
+};
+
+// Each builds the model's LPs from the trace's parameters, once per pass, and
+// replays the trace through them. They return false if the trace does not
+// match the model.
+bool ReplayPhold(TraceReader& trace, unsigned int passes);
+bool ReplayAirport(TraceReader& trace, unsigned int passes);
+bool ReplayPcs(TraceReader& trace, unsigned int passes);
+bool ReplayTraffic(TraceReader& trace, unsigned int passes);
+bool ReplayEpidemic(TraceReader& trace, unsigned int passes);
+
+#endif
@@ -0,0 +1,69 @@
+// Traffic intersections driven without the Time Warp kernel. See
+// event_driver.hpp.
+
+#include <vector>
+
+#include "util/benchmark.h"
+#include "traffic/traffic.hpp"
+#include "event_driver.hpp"
+#include "state_bench.hpp"
+
+static const unsigned int kGridSize = 32;
+
+static unsigned int TrafficEventType(const warped::Event& event) {
+    return static_cast<const TrafficEvent&>(event).type_;
+}
+
+static void RunTraffic(const char* name, int iters, const TrafficSignalPlan& signals) {
+    StopBenchmarkTiming();
+    LPNameRegistry lp_names {"Intersection_", kGridSize * kGridSize};
+    Torus2D grid {kGridSize, kGridSize};
+    RoadNetwork network = RoadNetwork::fromGrid(grid, 0, kGridRoadCapacity);
+    TrafficDemand demand;
+    std::vector<Intersection> lps;
+    auto make_lps = [&]() {
+        lps.clear();
+        for (unsigned int i = 0; i < kGridSize * kGridSize; i++) {
+            lps.emplace_back(lp_names, network, signals, demand, 25, 400, 10000, 0, i);
+        }
+        std::vector<warped::LogicalProcess*> lp_pointers;
+        for (auto& lp : lps) {
+            lp_pointers.push_back(&lp);
+        }
+        return lp_pointers;
+    };
+    EventDriver driver {name, make_lps, 
+                        {"ARRIVAL", "DEPARTURE", "DIRECTION_SELECT", "SIGNAL", "SOURCE"}, 
+                        TrafficEventType};
+
+    StartBenchmarkTiming();
+    driver.run(iters);
+    StopBenchmarkTiming();
+    driver.report();
+}
+
+static void BM_Traffic(int iters) {
+    RunTraffic("traffic", iters, TrafficSignalPlan());
+}
+BENCHMARK(BM_Traffic)->ThreadRange(1, 1);
+
+// Green waves along the rows: two-phase signals offset by a mean hop
+static void BM_TrafficSignalCorridors(int iters) {
+    TrafficSignalPlan signals;
+    signals.green_ = {1200, 800};
+    signals.offset_ = 800;
+    RunTraffic("traffic_signal_corridors", iters, signals);
+}
+BENCHMARK(BM_TrafficSignalCorridors)->ThreadRange(1, 1);
+
+static void BM_TrafficStateSaveRestore(int iters) {
+    TrafficState state {};
+    RunStateSaveRestore("BM_TrafficStateSaveRestore", iters, state);
+}
+BENCHMARK(BM_TrafficStateSaveRestore)->ThreadRange(1, 1);
+
+static void BM_TrafficStateSerialize(int iters) {
+    TrafficState state {};
+    RunStateSerialize("BM_TrafficStateSerialize", iters, state);
+}
+BENCHMARK(BM_TrafficStateSerialize)->ThreadRange(1, 1);
@@ -0,0 +1,72 @@
+// Cars the traffic OD demand injects against the rate of the matrix: feeds a
+// single origin its own SOURCE events up to a horizon, for each rate given,
+// and counts the cars that set off. The count of a Poisson process is within
+// four standard deviations of rate * horizon nearly always, so the program
+// fails if any rate misses by more.
+//
+//   traffic_demand_rate 200000 0.1 1 5 50
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "traffic/traffic.hpp"
+
+static const unsigned int kGridSize = 4;
+
+// Cars injected from intersection 0 with departures up to 'horizon'
+static unsigned long long CountCars(double rate, unsigned int horizon) {
+    std::istringstream matrix("0 5 " + std::to_string(rate));
+    std::string error;
+    TrafficDemand demand;
+    demand.loadMatrix(matrix, "matrix", kGridSize, kGridSize, error);
+    demand.setProfile("", 0, error);
+
+    LPNameRegistry lp_names {"Intersection_", kGridSize * kGridSize};
+    Torus2D grid {kGridSize, kGridSize};
+    RoadNetwork network = RoadNetwork::fromGrid(grid, 0, kGridRoadCapacity);
+    TrafficSignalPlan signals;
+    Intersection lp {lp_names, network, signals, demand, 0, 400, 10000, 0, 0};
+
+    unsigned long long cars = 0;
+    std::shared_ptr<warped::Event> source;
+    std::vector<std::shared_ptr<warped::Event>> events = lp.initializeLP();
+    while (true) {
+        source = nullptr;
+        for (auto& event : events) {
+            auto& traffic_event = static_cast<const TrafficEvent&>(*event);
+            if (traffic_event.type_ == ARRIVAL) cars++;
+            if (traffic_event.type_ == SOURCE) source = event;
+        }
+        if (!source || (source->timestamp() > horizon)) break;
+        events = lp.receiveEvent(*source);
+    }
+    return cars;
+}
+
+int main(int argc, const char** argv) {
+    unsigned int horizon = (argc > 1) ? std::stoul(argv[1]) : 200000;
+    std::vector<double> rates;
+    for (int i = 2; i < argc; i++) {
+        rates.push_back(std::stod(argv[i]));
+    }
+    if (rates.empty()) {
+        rates = {0.1, 1.0, 5.0, 50.0};
+    }
+
+    bool all_within = true;
+    std::printf("%10s %12s %12s %10s %10s\n", "rate", "expected", "injected", "cars/unit",
+                                                                                "off by sd");
+    for (auto rate : rates) {
+        double expected = rate * horizon;
+        unsigned long long cars = CountCars(rate, horizon);
+        double off_by = (cars - expected) / std::sqrt(expected);
+        std::printf("%10.3f %12.0f %12llu %10.4f %10.2f\n", rate, expected, cars,
+                                                    (double) cars / horizon, off_by);
+        all_within = all_within && (std::fabs(off_by) <= 4.0);
+    }
+    return all_within ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+#ifndef WARPED_MODELS_UTILITY_EVENT_PROFILE_HPP
+#define WARPED_MODELS_UTILITY_EVENT_PROFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Per event type profile of a model's receiveEvent(), chosen at compile time.
+// A model names its policy once,
+//
+//   typedef EventProfile<Intersection, 3> IntersectionProfile;
+//
+// and brackets the body of receiveEvent() with it:
+//
+//   auto profile = IntersectionProfile::start(traffic_event.type_);
+//   ...
+//   IntersectionProfile::stop(profile, events.size());
+//   return events;
+//
+// Configured with --enable-event-profile, every worker thread counts the
+// events of each type it processes, rolled back ones included, with their
+// fan-out, and reads the cycle counter around one event in every
+// kSamplePeriod of each type. The tables are printed per thread with
+// report() once simulate() returns. Otherwise the policy is NullEventProfile,
+// whose calls are empty and compile to nothing.
+
+class NullEventProfile {
+public:
+    struct Sample {};
+
+    static Sample start(unsigned int) { return Sample(); }
+    static void stop(const Sample&, std::size_t) {}
+
+    template <std::size_t N>
+    static void report(const char*, const char* const (&)[N]) {}
+};
+
+template <typename Model, unsigned int NumTypes>
+class CycleEventProfile {
+public:
+    static const unsigned int kSamplePeriod = 64;
+
+    struct Sample {
+        unsigned int type_;
+        std::uint64_t start_;   // Zero if this event is not sampled
+    };
+
+    static Sample start(unsigned int type) {
+        TypeCounters& counters = threadTable().types_[type];
+        bool sampled = (counters.events_++ % kSamplePeriod) == 0;
+        return Sample {type, sampled ? readCycles() : 0};
+    }
+
+    static void stop(const Sample& sample, std::size_t num_sent) {
+        TypeCounters& counters = threadTable().types_[sample.type_];
+        counters.sent_ += num_sent;
+        if (sample.start_) {
+            counters.cycles_ += readCycles() - sample.start_;
+            counters.samples_++;
+        }
+    }
+
+    // Prints one table per thread that processed events. The cycle share is
+    // estimated as events x mean sampled cycles.
+    template <std::size_t N>
+    static void report(const char* model, const char* const (&type_names)[N]) {
+        static_assert(N == NumTypes, "one name per event type");
+        Registry& registry = tables();
+        std::lock_guard<std::mutex> lock(registry.mutex_);
+
+        for (unsigned int thread = 0; thread < registry.tables_.size(); thread++) {
+            const Table& table = *registry.tables_[thread];
+            double total_cycles = 0.0;
+            for (auto& counters : table.types_) {
+                total_cycles += counters.events_ * meanCycles(counters);
+            }
+            std::printf("\n%s event profile, worker %u\n", model, thread);
+            std::printf("%-24s %12s %14s %10s %10s\n", "event type", "events",
+                            "cycles/event", "cycles %", "fan-out");
+            for (unsigned int type = 0; type < NumTypes; type++) {
+                const TypeCounters& counters = table.types_[type];
+                double events = counters.events_ ? (double) counters.events_ : 1.0;
+                double cycles = meanCycles(counters);
+                std::printf("%-24s %12llu %14.0f %10.1f %10.2f\n", type_names[type],
+                    (unsigned long long) counters.events_, cycles,
+                    total_cycles ? 100.0 * counters.events_ * cycles / total_cycles : 0.0,
+                    counters.sent_ / events);
+            }
+        }
+    }
+
+private:
+    struct TypeCounters {
+        std::uint64_t events_;
+        std::uint64_t samples_;
+        std::uint64_t cycles_;
+        std::uint64_t sent_;
+    };
+
+    struct Table {
+        TypeCounters types_[NumTypes];
+    };
+
+    // Tables outlive their threads so that they can be reported after
+    // simulate() has joined the workers
+    struct Registry {
+        std::mutex mutex_;
+        std::vector<std::unique_ptr<Table>> tables_;
+    };
+
+    static Registry& tables() {
+        static Registry registry;
+        return registry;
+    }
+
+    static Table& threadTable() {
+        static thread_local Table* table = nullptr;
+        if (!table) {
+            Registry& registry = tables();
+            std::lock_guard<std::mutex> lock(registry.mutex_);
+            registry.tables_.emplace_back(new Table());
+            table = registry.tables_.back().get();
+        }
+        return *table;
+    }
+
+    static double meanCycles(const TypeCounters& counters) {
+        return counters.samples_ ? (double) counters.cycles_ / counters.samples_ : 0.0;
+    }
+
+    static std::uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+};
+
+#ifdef WARPED_MODELS_EVENT_PROFILE
+template <typename Model, unsigned int NumTypes>
+using EventProfile = CycleEventProfile<Model, NumTypes>;
+#else
+template <typename Model, unsigned int NumTypes>
+using EventProfile = NullEventProfile;
+#endif
+
+#endif
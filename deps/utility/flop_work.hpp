@@ -0,0 +1,38 @@
+#ifndef WARPED_MODELS_UTILITY_FLOP_WORK_HPP
+#define WARPED_MODELS_UTILITY_FLOP_WORK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// Synthetic computation for benchmark models: a chain of dependent
+// multiply-adds, so that the work cannot be vectorized or overlapped and its
+// cost grows linearly with the number of floating-point operations.
+
+// Does 'flops' floating-point operations, two per multiply-add
+inline void doFlops(std::uint64_t flops) {
+    static thread_local volatile double sink = 1.0;
+    double x = sink;
+    for (std::uint64_t i = 0; i < flops / 2; i++) {
+        x = x * 0.999999 + 1e-6;
+    }
+    sink = x;
+}
+
+// Dependent floating-point operations per nanosecond on this machine, from
+// the fastest of a few timed runs of doFlops()
+inline double calibrateFlopsPerNanosecond() {
+    typedef std::chrono::steady_clock clock;
+    const std::uint64_t kFlops = 1 << 22;
+
+    double best = 0.0;
+    for (unsigned int run = 0; run < 5; run++) {
+        clock::time_point start = clock::now();
+        doFlops(kFlops);
+        double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        best = std::max(best, kFlops / std::max(ns, 1.0));
+    }
+    return best;
+}
+
+#endif
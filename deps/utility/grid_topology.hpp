@@ -0,0 +1,137 @@
+#ifndef WARPED_MODELS_UTILITY_GRID_TOPOLOGY_HPP
+#define WARPED_MODELS_UTILITY_GRID_TOPOLOGY_HPP
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Grid layouts for GridTopology. Each one names its neighbour directions and
+// gives the coordinate offset of every direction; directions come in
+// opposite pairs, so (dir ^ 1) is the reverse of dir. LP indices are
+// row-major: index = x + y * size_x + z * size_x * size_y.
+
+// Square cells with four neighbours
+struct SquareGrid2D {
+    static const unsigned int kDims = 2;
+    static const unsigned int kDegree = 4;
+
+    enum direction { LEFT, RIGHT, DOWN, UP };
+
+    static void offset(const unsigned int (&coords)[3], unsigned int dir, int (&delta)[3]) {
+        static const int offsets[kDegree][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+        (void) coords;
+        delta[0] = offsets[dir][0];
+        delta[1] = offsets[dir][1];
+        delta[2] = 0;
+    }
+};
+
+// Hexagonal cells with six neighbours, in "odd-r" offset coordinates: odd
+// rows are shifted half a cell to the right. Wrapping vertically needs an
+// even number of rows.
+struct HexGrid2D {
+    static const unsigned int kDims = 2;
+    static const unsigned int kDegree = 6;
+
+    enum direction { WEST, EAST, SOUTH_WEST, NORTH_EAST, SOUTH_EAST, NORTH_WEST };
+
+    static void offset(const unsigned int (&coords)[3], unsigned int dir, int (&delta)[3]) {
+        static const int offsets[2][kDegree][2] = {
+            { {-1, 0}, {1, 0}, {-1, -1}, {0, 1}, {0, -1}, {-1, 1} },    // even rows
+            { {-1, 0}, {1, 0}, {0, -1}, {1, 1}, {1, -1}, {0, 1} }       // odd rows
+        };
+        unsigned int parity = coords[1] & 1;
+        delta[0] = offsets[parity][dir][0];
+        delta[1] = offsets[parity][dir][1];
+        delta[2] = 0;
+    }
+};
+
+// Cubic cells with six face neighbours
+struct CubeGrid3D {
+    static const unsigned int kDims = 3;
+    static const unsigned int kDegree = 6;
+
+    enum direction { LEFT, RIGHT, DOWN, UP, BACK, FRONT };
+
+    static void offset(const unsigned int (&coords)[3], unsigned int dir, int (&delta)[3]) {
+        static const int offsets[kDegree][3] = {
+            {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+        };
+        (void) coords;
+        delta[0] = offsets[dir][0];
+        delta[1] = offsets[dir][1];
+        delta[2] = offsets[dir][2];
+    }
+};
+
+// Neighbour lookup for LPs laid out on a regular grid. The table of every
+// cell's neighbours is built once at startup and shared by all LPs, so a move
+// is a single load from a row whose width is known at compile time. When Wrap
+// is set the grid is a torus; otherwise a move off the edge stays in place.
+template <typename Layout, bool Wrap>
+class GridTopology {
+public:
+    static const unsigned int kDims = Layout::kDims;
+    static const unsigned int kDegree = Layout::kDegree;
+
+    GridTopology(unsigned int size_x, unsigned int size_y, unsigned int size_z = 1)
+            : size_ {size_x, size_y, size_z} {
+
+        if ((kDims < 3) && (size_z != 1)) {
+            std::cerr << "Grid topology: a 2D layout cannot have depth " << size_z << std::endl;
+            abort();
+        }
+
+        unsigned int num_cells = size_x * size_y * size_z;
+        neighbours_.resize(num_cells * kDegree);
+
+        for (unsigned int index = 0; index < num_cells; index++) {
+            unsigned int coords[3] = { index % size_x, (index / size_x) % size_y,
+                                                    index / (size_x * size_y) };
+            for (unsigned int dir = 0; dir < kDegree; dir++) {
+                int delta[3];
+                Layout::offset(coords, dir, delta);
+
+                unsigned int target[3];
+                bool on_grid = true;
+                for (unsigned int dim = 0; dim < 3; dim++) {
+                    int coord = (int) coords[dim] + delta[dim];
+                    if (Wrap) {
+                        coord = (coord + (int) size_[dim]) % (int) size_[dim];
+                    } else if ((coord < 0) || (coord >= (int) size_[dim])) {
+                        on_grid = false;
+                    }
+                    target[dim] = (unsigned int) coord;
+                }
+
+                neighbours_[index * kDegree + dir] = on_grid ?
+                    target[0] + target[1] * size_x + target[2] * size_x * size_y : index;
+            }
+        }
+    }
+
+    unsigned int neighbour(unsigned int index, unsigned int direction) const {
+        assert(direction < kDegree);
+        return neighbours_[index * kDegree + direction];
+    }
+
+    unsigned int size() const { return size_[0] * size_[1] * size_[2]; }
+    unsigned int sizeX() const { return size_[0]; }
+    unsigned int sizeY() const { return size_[1]; }
+    unsigned int sizeZ() const { return size_[2]; }
+
+private:
+    const unsigned int size_[3];
+    std::vector<unsigned int> neighbours_;
+};
+
+typedef GridTopology<SquareGrid2D, true>    Torus2D;
+typedef GridTopology<SquareGrid2D, false>   BoundedGrid2D;
+typedef GridTopology<HexGrid2D, true>       HexTorus2D;
+typedef GridTopology<HexGrid2D, false>      BoundedHexGrid2D;
+typedef GridTopology<CubeGrid3D, true>      Torus3D;
+typedef GridTopology<CubeGrid3D, false>     BoundedGrid3D;
+
+#endif
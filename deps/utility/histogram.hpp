@@ -0,0 +1,62 @@
+#ifndef WARPED_MODELS_UTILITY_HISTOGRAM_HPP
+#define WARPED_MODELS_UTILITY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Histogram with a fixed number of equal-width buckets, plain enough to sit in
+// an LP's POD state, so that rolled-back events take their samples with them
+// and the final states hold committed samples only. The last bucket also
+// counts everything beyond the others. The bucket width is a run-wide
+// setting passed to each call, rather than repeated in every LP's state.
+// A bucket stops at the largest Count instead of wrapping; compare total()
+// with the samples added to tell.
+//
+// Per-LP histograms are merged after simulate() into one with wider counters:
+//
+//   FixedHistogram<32, std::uint64_t> trips {};
+//   for (auto& lp : lps) trips.merge(lp.state_.trip_times_);
+
+template <unsigned int NumBuckets, typename Count = std::uint32_t>
+struct FixedHistogram {
+    static const unsigned int kNumBuckets = NumBuckets;
+
+    Count counts_[NumBuckets];
+
+    void add(std::uint64_t value, std::uint64_t width) {
+        Count& count = counts_[std::min<std::uint64_t>(value / width, NumBuckets - 1)];
+        if (count < std::numeric_limits<Count>::max()) count++;
+    }
+
+    template <typename OtherCount>
+    void merge(const FixedHistogram<NumBuckets, OtherCount>& other) {
+        for (unsigned int bucket = 0; bucket < NumBuckets; bucket++) {
+            counts_[bucket] += other.counts_[bucket];
+        }
+    }
+
+    std::uint64_t total() const {
+        std::uint64_t total = 0;
+        for (auto count : counts_) total += count;
+        return total;
+    }
+
+    // Upper edge of the bucket holding the q-quantile, e.g. q = 0.99; zero
+    // if there are no samples. Quantiles in the last bucket are open-ended
+    // and come out as its lower edge.
+    std::uint64_t quantile(double q, std::uint64_t width) const {
+        std::uint64_t total = this->total();
+        if (!total) return 0;
+        std::uint64_t rank = std::max<std::uint64_t>((std::uint64_t) std::ceil(q * total), 1);
+        std::uint64_t seen = 0;
+        for (unsigned int bucket = 0; bucket < NumBuckets - 1; bucket++) {
+            seen += counts_[bucket];
+            if (seen >= rank) return (bucket + 1) * width;
+        }
+        return (NumBuckets - 1) * width;
+    }
+};
+
+#endif
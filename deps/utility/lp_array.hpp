@@ -0,0 +1,65 @@
+#ifndef WARPED_MODELS_UTILITY_LP_ARRAY_HPP
+#define WARPED_MODELS_UTILITY_LP_ARRAY_HPP
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "parallel.hpp"
+
+// Fixed-size array of LPs, allocated once and built in place by every
+// hardware thread at once. At millions of LPs, filling a std::vector with
+// emplace_back() builds them on one thread and copies all of them every time
+// it grows.
+template <typename LP>
+class LPArray {
+public:
+    // Builds LP(args..., index) for every index in [0, size)
+    template <typename... Args>
+    LPArray(std::size_t size, const Args&... args)
+        : lps_(static_cast<LP*>(::operator new(size * sizeof(LP)))), size_(size) {
+        parallelFor(size, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                new (&lps_[i]) LP(args..., (unsigned int) i);
+            }
+        });
+    }
+
+    LPArray(const LPArray&) = delete;
+    LPArray& operator=(const LPArray&) = delete;
+
+    ~LPArray() {
+        for (std::size_t i = 0; i < size_; i++) {
+            lps_[i].~LP();
+        }
+        ::operator delete(lps_);
+    }
+
+    // Pointers to every LP as one of its bases, e.g. warped::LogicalProcess
+    // for simulate()
+    template <typename Base>
+    std::vector<Base*> pointers() {
+        std::vector<Base*> pointers(size_);
+        parallelFor(size_, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                pointers[i] = &lps_[i];
+            }
+        });
+        return pointers;
+    }
+
+    LP& operator[](std::size_t index) { return lps_[index]; }
+    const LP& operator[](std::size_t index) const { return lps_[index]; }
+    std::size_t size() const { return size_; }
+
+    LP* begin() { return lps_; }
+    LP* end() { return lps_ + size_; }
+    const LP* begin() const { return lps_; }
+    const LP* end() const { return lps_ + size_; }
+
+private:
+    LP* lps_;
+    std::size_t size_;
+};
+
+#endif
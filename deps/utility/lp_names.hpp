@@ -0,0 +1,41 @@
+#ifndef WARPED_MODELS_UTILITY_LP_NAMES_HPP
+#define WARPED_MODELS_UTILITY_LP_NAMES_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "parallel.hpp"
+
+// Interned table of LP names, built once at startup and shared by every LP of
+// a model. Turning a destination index into a receiver name is then a plain
+// array lookup that returns a reference, instead of a string concatenation and
+// an itoa call on every event.
+class LPNameRegistry {
+public:
+    LPNameRegistry() = default;
+
+    // Names of the form <prefix><index>, for index in [0, count)
+    LPNameRegistry(const std::string& prefix, unsigned int count) : names_(count) {
+        parallelFor(count, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t index = begin; index < end; index++) {
+                names_[index] = prefix + std::to_string(index);
+            }
+        });
+    }
+
+    // Arbitrary names (e.g. read from a config file), indexed in the given order
+    explicit LPNameRegistry(std::vector<std::string> names) : names_(std::move(names)) {}
+
+    LPNameRegistry(const LPNameRegistry&) = delete;
+    LPNameRegistry& operator=(const LPNameRegistry&) = delete;
+
+    const std::string& operator[](unsigned int index) const { return names_[index]; }
+
+    unsigned int size() const { return names_.size(); }
+
+private:
+    std::vector<std::string> names_;
+};
+
+#endif
@@ -1,7 +1,9 @@
 #ifndef WARPED_MODELS_UTILITY_MEMORY_HPP
 #define WARPED_MODELS_UTILITY_MEMORY_HPP
 
+#include <cstddef>
 #include <memory>
+#include <new>
 #include <utility>
 
 // This is a back-port of C++14's std::make_unique<> to C++11 taken from from
@@ -12,4 +14,114 @@ std::unique_ptr<T> make_unique(Args&& ...args) {
     return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
 }
 
+// A per-thread free list of fixed-size blocks. There is one list per block
+// type and thread, so allocation and release never synchronize. A block may be
+// released on a different thread than the one that allocated it; it then
+// simply joins the releasing thread's list. At most MaxCached blocks are kept
+// per list, the rest go back to the global heap.
+template<typename Block, std::size_t MaxCached = 16384>
+class ThreadLocalFreeList {
+public:
+    static ThreadLocalFreeList& local() {
+        static thread_local ThreadLocalFreeList list;
+        return list;
+    }
+
+    void* pop() {
+        if (!head_) {
+            return ::operator new(sizeof(Block));
+        }
+        Node* node = head_;
+        head_ = node->next_;
+        num_cached_--;
+        return node;
+    }
+
+    void push(void* block) {
+        if (num_cached_ == MaxCached) {
+            ::operator delete(block);
+            return;
+        }
+        Node* node = static_cast<Node*>(block);
+        node->next_ = head_;
+        head_ = node;
+        num_cached_++;
+    }
+
+    ~ThreadLocalFreeList() {
+        while (head_) {
+            Node* node = head_;
+            head_ = node->next_;
+            ::operator delete(node);
+        }
+    }
+
+private:
+    struct Node {
+        Node* next_;
+    };
+
+    static_assert(sizeof(Block) >= sizeof(Node), "Pooled block is too small");
+    static_assert(alignof(Block) <= alignof(std::max_align_t), "Pooled block is over-aligned");
+
+    ThreadLocalFreeList() = default;
+
+    Node* head_ = nullptr;
+    std::size_t num_cached_ = 0;
+};
+
+// Standard allocator backed by ThreadLocalFreeList. std::allocate_shared
+// rebinds it to its combined control block and object type, so each event
+// type ends up with its own pool of exactly-sized blocks.
+template<typename T>
+class PoolAllocator {
+public:
+    typedef T value_type;
+
+    PoolAllocator() noexcept = default;
+    template<typename U> PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n != 1) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(ThreadLocalFreeList<T>::local().pop());
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (n != 1) {
+            ::operator delete(p);
+            return;
+        }
+        ThreadLocalFreeList<T>::local().push(p);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) { return true; }
+
+template<typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) { return false; }
+
+// Factory for model events. The allocation strategy is chosen at configure
+// time (--with-event-allocator) so that the models can be compared against
+// each other and against a tcmalloc build:
+//   pool   - std::allocate_shared from per-thread pools (default), one block
+//            holding both the control block and the event
+//   shared - std::make_shared, one allocation from the global heap
+//   new    - a raw new wrapped in std::shared_ptr, two allocations
+// Arguments are forwarded to a constructor call, so callers that draw random
+// numbers for several arguments must do so beforehand to keep the draw order
+// fixed.
+template<typename T, typename ...Args>
+std::shared_ptr<T> make_event(Args&& ...args) {
+#if defined(WARPED_MODELS_EVENT_ALLOCATOR_NEW)
+    return std::shared_ptr<T>(new T(std::forward<Args>(args)...));
+#elif defined(WARPED_MODELS_EVENT_ALLOCATOR_SHARED)
+    return std::make_shared<T>(std::forward<Args>(args)...);
+#else
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+#endif
+}
+
 #endif
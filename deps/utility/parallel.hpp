@@ -0,0 +1,35 @@
+#ifndef WARPED_MODELS_UTILITY_PARALLEL_HPP
+#define WARPED_MODELS_UTILITY_PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Calls fn(begin, end) on contiguous chunks that cover [0, n), one chunk per
+// hardware thread, and returns once every chunk is done. Ranges too small to
+// be worth a thread are run on the calling thread. Meant for startup work
+// over every LP, such as building LPs and their names.
+template <typename Fn>
+void parallelFor(std::size_t n, Fn fn) {
+    const std::size_t kMinChunk = 1 << 16;
+
+    std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    threads = std::min(threads, (n + kMinChunk - 1) / kMinChunk);
+    if (threads <= 1) {
+        fn((std::size_t) 0, n);
+        return;
+    }
+
+    std::size_t chunk = (n + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    for (std::size_t begin = chunk; begin < n; begin += chunk) {
+        workers.emplace_back(fn, begin, std::min(begin + chunk, n));
+    }
+    fn((std::size_t) 0, chunk);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef WARPED_MODELS_UTILITY_PHILOX_HPP
+#define WARPED_MODELS_UTILITY_PHILOX_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+// Philox4x32-10 counter-based random number engine, from "Parallel Random
+// Numbers: As Easy as 1, 2, 3" by Salmon et al. (SC'11).
+//
+// Each 128-bit block of output is a keyed bijection of a 128-bit counter, so
+// the whole engine state is the key (the global seed), the stream (the LP
+// index) and the position in the stream. Saving and restoring it is a copy of
+// a few words, and seek() jumps to any position without generating the
+// outputs in between. Distinct streams under one key never overlap.
+//
+// Meets the UniformRandomBitGenerator requirements, so it plugs into the
+// <random> distributions, and provides the stream operators that
+// LogicalProcess::registerRNG() uses to save and restore generator state.
+class Philox4x32 {
+public:
+    typedef std::uint32_t result_type;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return 0xFFFFFFFF; }
+
+    explicit Philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0) {
+        this->seed(seed, stream);
+    }
+
+    void seed(std::uint64_t seed, std::uint64_t stream = 0) {
+        key_[0] = (std::uint32_t) seed;
+        key_[1] = (std::uint32_t) (seed >> 32);
+        stream_ = stream;
+        position_ = 0;
+        for (unsigned int i = 0; i < 4; i++) {
+            block_[i] = 0;
+        }
+    }
+
+    result_type operator()() {
+        unsigned int word = position_ & 3;
+        if (!word) {
+            generateBlock();
+        }
+        position_++;
+        return block_[word];
+    }
+
+    // Jump to the n-th output of the stream
+    void seek(std::uint64_t position) {
+        position_ = position;
+        if (position_ & 3) {
+            generateBlock();
+        }
+    }
+
+    void discard(unsigned long long z) { seek(position_ + z); }
+
+    std::uint64_t position() const { return position_; }
+    std::uint64_t stream() const { return stream_; }
+
+    friend bool operator==(const Philox4x32& lhs, const Philox4x32& rhs) {
+        return (lhs.key_[0] == rhs.key_[0]) && (lhs.key_[1] == rhs.key_[1]) &&
+                (lhs.stream_ == rhs.stream_) && (lhs.position_ == rhs.position_);
+    }
+
+    friend bool operator!=(const Philox4x32& lhs, const Philox4x32& rhs) {
+        return !(lhs == rhs);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Philox4x32& rng) {
+        return os << rng.key_[0] << ' ' << rng.key_[1] << ' '
+                        << rng.stream_ << ' ' << rng.position_;
+    }
+
+    friend std::istream& operator>>(std::istream& is, Philox4x32& rng) {
+        std::uint64_t position;
+        is >> rng.key_[0] >> rng.key_[1] >> rng.stream_ >> position;
+        rng.seek(position);
+        return is;
+    }
+
+private:
+    static const std::uint32_t kMultiplier0 = 0xD2511F53;
+    static const std::uint32_t kMultiplier1 = 0xCD9E8D57;
+    static const std::uint32_t kWeyl0 = 0x9E3779B9;
+    static const std::uint32_t kWeyl1 = 0xBB67AE85;
+    static const unsigned int kRounds = 10;
+
+    // Block counter in the low 64 bits of the counter, stream in the high 64
+    void generateBlock() {
+        std::uint64_t block = position_ >> 2;
+        std::uint32_t ctr[4] = { (std::uint32_t) block, (std::uint32_t) (block >> 32),
+                                    (std::uint32_t) stream_, (std::uint32_t) (stream_ >> 32) };
+        std::uint32_t key[2] = { key_[0], key_[1] };
+
+        for (unsigned int round = 0; round < kRounds; round++) {
+            if (round) {
+                key[0] += kWeyl0;
+                key[1] += kWeyl1;
+            }
+            std::uint64_t product0 = (std::uint64_t) kMultiplier0 * ctr[0];
+            std::uint64_t product1 = (std::uint64_t) kMultiplier1 * ctr[2];
+            std::uint32_t next[4] = {
+                (std::uint32_t) (product1 >> 32) ^ ctr[1] ^ key[0],
+                (std::uint32_t) product1,
+                (std::uint32_t) (product0 >> 32) ^ ctr[3] ^ key[1],
+                (std::uint32_t) product0 };
+            for (unsigned int i = 0; i < 4; i++) {
+                ctr[i] = next[i];
+            }
+        }
+        for (unsigned int i = 0; i < 4; i++) {
+            block_[i] = ctr[i];
+        }
+    }
+
+    std::uint32_t key_[2];
+    std::uint64_t stream_;
+    std::uint64_t position_;
+
+    // Cached output of the current block; derived from the state above
+    std::uint32_t block_[4];
+};
+
+#endif
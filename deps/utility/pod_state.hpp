@@ -0,0 +1,79 @@
+#ifndef WARPED_MODELS_UTILITY_POD_STATE_HPP
+#define WARPED_MODELS_UTILITY_POD_STATE_HPP
+
+#include <cstddef>
+#include <type_traits>
+
+#include "cereal/cereal.hpp"
+
+// LP states keep their data in a plain struct that the state inherits next to
+// warped::LPStateClass, e.g.
+//
+//   struct AirportCounters { unsigned int arrivals_; ... };
+//   WARPED_MODELS_ASSERT_POD_STATE(AirportCounters);
+//
+//   WARPED_DEFINE_LP_STATE_STRUCT(AirportState), public AirportCounters {
+//       template <typename Archive>
+//       void save(Archive& ar) const { savePodState<AirportCounters>(ar, *this); }
+//       template <typename Archive>
+//       void load(Archive& ar) { loadPodState<AirportCounters>(ar, *this); }
+//   };
+//
+// The plain part is then copied with a memcpy when the kernel saves a state,
+// and a checkpoint writes it as one block of bytes instead of member by member.
+
+#define WARPED_MODELS_ASSERT_POD_STATE(Data)                                        \
+    static_assert(std::is_trivially_copyable<Data>::value &&                        \
+                    std::is_standard_layout<Data>::value,                           \
+                    #Data " must be trivially copyable and standard-layout")
+
+namespace pod_state_detail {
+
+typedef cereal::BinaryData<const unsigned char*> ConstBytes;
+typedef cereal::BinaryData<unsigned char*> Bytes;
+
+// Binary archives take the whole struct as one block
+template <class Archive, class Data>
+void save(Archive& ar, const Data& data, std::true_type) {
+    ar(cereal::binary_data(reinterpret_cast<const unsigned char*>(&data), sizeof(Data)));
+}
+
+template <class Archive, class Data>
+void load(Archive& ar, Data& data, std::true_type) {
+    ar(cereal::binary_data(reinterpret_cast<unsigned char*>(&data), sizeof(Data)));
+}
+
+// Other archives (e.g. JSON) get the bytes one at a time
+template <class Archive, class Data>
+void save(Archive& ar, const Data& data, std::false_type) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&data);
+    for (std::size_t i = 0; i < sizeof(Data); i++) {
+        ar(bytes[i]);
+    }
+}
+
+template <class Archive, class Data>
+void load(Archive& ar, Data& data, std::false_type) {
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(&data);
+    for (std::size_t i = 0; i < sizeof(Data); i++) {
+        ar(bytes[i]);
+    }
+}
+
+} // namespace pod_state_detail
+
+template <class Data, class Archive>
+void savePodState(Archive& ar, const Data& data) {
+    WARPED_MODELS_ASSERT_POD_STATE(Data);
+    pod_state_detail::save(ar, data, std::integral_constant<bool,
+        cereal::traits::is_output_serializable<pod_state_detail::ConstBytes, Archive>::value>());
+}
+
+template <class Data, class Archive>
+void loadPodState(Archive& ar, Data& data) {
+    WARPED_MODELS_ASSERT_POD_STATE(Data);
+    pod_state_detail::load(ar, data, std::integral_constant<bool,
+        cereal::traits::is_input_serializable<pod_state_detail::Bytes, Archive>::value>());
+}
+
+#endif
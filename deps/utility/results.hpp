@@ -0,0 +1,212 @@
+#ifndef WARPED_MODELS_UTILITY_RESULTS_HPP
+#define WARPED_MODELS_UTILITY_RESULTS_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Columnar binary file of per-LP results, written once after simulate(). Row
+// i holds the final state of LP i. The file is
+//
+//   magic        8 bytes, "WMRESULT"
+//   num_columns  uint32
+//   num_rows     uint64
+//   for each column:
+//     type       uint8, a ResultColumnType
+//     name_size  uint16
+//     name       name_size bytes
+//   for each column, in the same order:
+//     num_rows fixed-width values, or for STRING columns num_rows entries of
+//     a uint32 size followed by the bytes
+//
+// All numbers are in host byte order. tools/results_to_csv converts a file to
+// CSV.
+
+enum class ResultColumnType : std::uint8_t {
+    UINT32  = 0,
+    UINT64  = 1,
+    INT64   = 2,
+    FLOAT64 = 3,
+    STRING  = 4
+};
+
+template <typename T> struct ResultColumnTraits;
+template <> struct ResultColumnTraits<std::uint32_t> {
+    static const ResultColumnType kType = ResultColumnType::UINT32;
+};
+template <> struct ResultColumnTraits<std::uint64_t> {
+    static const ResultColumnType kType = ResultColumnType::UINT64;
+};
+template <> struct ResultColumnTraits<std::int64_t> {
+    static const ResultColumnType kType = ResultColumnType::INT64;
+};
+template <> struct ResultColumnTraits<double> {
+    static const ResultColumnType kType = ResultColumnType::FLOAT64;
+};
+
+const char kResultsMagic[8] = {'W', 'M', 'R', 'E', 'S', 'U', 'L', 'T'};
+
+class ResultsWriter {
+public:
+    explicit ResultsWriter(std::uint64_t num_rows) : num_rows_(num_rows) {}
+
+    // value_of(i) gives the value of row i
+    template <typename T, typename ValueOf>
+    void addColumn(const std::string& name, ValueOf value_of) {
+        Column column {name, ResultColumnTraits<T>::kType, {}};
+        column.data_.resize(num_rows_ * sizeof(T));
+        char* out = column.data_.data();
+        for (std::uint64_t i = 0; i < num_rows_; i++) {
+            T value = value_of(i);
+            std::memcpy(out + i * sizeof(T), &value, sizeof(T));
+        }
+        columns_.push_back(std::move(column));
+    }
+
+    template <typename ValueOf>
+    void addStringColumn(const std::string& name, ValueOf value_of) {
+        Column column {name, ResultColumnType::STRING, {}};
+        for (std::uint64_t i = 0; i < num_rows_; i++) {
+            const std::string& value = value_of(i);
+            std::uint32_t size = value.size();
+            column.data_.insert(column.data_.end(), (const char*) &size,
+                                                    (const char*) &size + sizeof size);
+            column.data_.insert(column.data_.end(), value.begin(), value.end());
+        }
+        columns_.push_back(std::move(column));
+    }
+
+    // Returns false if the file could not be written
+    bool write(const std::string& filename) const {
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+
+        std::uint32_t num_columns = columns_.size();
+        out.write(kResultsMagic, sizeof kResultsMagic);
+        out.write((const char*) &num_columns, sizeof num_columns);
+        out.write((const char*) &num_rows_, sizeof num_rows_);
+        for (auto& column : columns_) {
+            std::uint8_t type = (std::uint8_t) column.type_;
+            std::uint16_t name_size = column.name_.size();
+            out.write((const char*) &type, sizeof type);
+            out.write((const char*) &name_size, sizeof name_size);
+            out.write(column.name_.data(), name_size);
+        }
+        for (auto& column : columns_) {
+            out.write(column.data_.data(), column.data_.size());
+        }
+        return (bool) out;
+    }
+
+private:
+    struct Column {
+        std::string name_;
+        ResultColumnType type_;
+        std::vector<char> data_;
+    };
+
+    std::uint64_t num_rows_;
+    std::vector<Column> columns_;
+};
+
+// Reads a whole results file into memory
+class ResultsReader {
+public:
+    struct Column {
+        std::string name_;
+        ResultColumnType type_;
+        // Start of the column's values in the file data
+        std::uint64_t start_;
+        // Start of each row's entry, for STRING columns only
+        std::vector<std::uint64_t> offsets_;
+    };
+
+    // Returns false if the file is missing, truncated or not a results file
+    bool read(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in) return false;
+        data_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+        std::uint64_t position = 0;
+        char magic[sizeof kResultsMagic];
+        std::uint32_t num_columns;
+        if (!take(position, magic, sizeof magic) ||
+                std::memcmp(magic, kResultsMagic, sizeof magic) ||
+                !take(position, &num_columns, sizeof num_columns) ||
+                !take(position, &num_rows_, sizeof num_rows_)) {
+            return false;
+        }
+
+        columns_.resize(num_columns);
+        for (auto& column : columns_) {
+            std::uint8_t type;
+            std::uint16_t name_size;
+            if (!take(position, &type, sizeof type) ||
+                    (type > (std::uint8_t) ResultColumnType::STRING) ||
+                    !take(position, &name_size, sizeof name_size) ||
+                    (position + name_size > data_.size())) {
+                return false;
+            }
+            column.type_ = (ResultColumnType) type;
+            column.name_.assign(&data_[position], name_size);
+            position += name_size;
+        }
+
+        for (auto& column : columns_) {
+            column.start_ = position;
+            if (column.type_ != ResultColumnType::STRING) {
+                position += num_rows_ * valueSize(column.type_);
+                if (position > data_.size()) return false;
+                continue;
+            }
+            column.offsets_.resize(num_rows_);
+            for (std::uint64_t row = 0; row < num_rows_; row++) {
+                column.offsets_[row] = position;
+                std::uint32_t size;
+                if (!take(position, &size, sizeof size) || (position + size > data_.size())) {
+                    return false;
+                }
+                position += size;
+            }
+        }
+        return true;
+    }
+
+    std::uint64_t numRows() const { return num_rows_; }
+    const std::vector<Column>& columns() const { return columns_; }
+
+    template <typename T>
+    T value(const Column& column, std::uint64_t row) const {
+        T value;
+        std::memcpy(&value, &data_[column.start_ + row * sizeof value], sizeof value);
+        return value;
+    }
+
+    std::string stringValue(const Column& column, std::uint64_t row) const {
+        std::uint32_t size;
+        std::memcpy(&size, &data_[column.offsets_[row]], sizeof size);
+        return std::string(&data_[column.offsets_[row] + sizeof size], size);
+    }
+
+private:
+    static std::uint64_t valueSize(ResultColumnType type) {
+        return (type == ResultColumnType::UINT32) ? 4 : 8;
+    }
+
+    bool take(std::uint64_t& position, void* out, std::size_t size) const {
+        if (position + size > data_.size()) return false;
+        std::memcpy(out, &data_[position], size);
+        position += size;
+        return true;
+    }
+
+    std::vector<char> data_;
+    std::uint64_t num_rows_ = 0;
+    std::vector<Column> columns_;
+};
+
+#endif
@@ -0,0 +1,235 @@
+#ifndef WARPED_MODELS_UTILITY_ROAD_NETWORK_HPP
+#define WARPED_MODELS_UTILITY_ROAD_NETWORK_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "grid_topology.hpp"
+
+// Directed road graph in compressed sparse row form, laid out in memory
+// exactly as in its file, so that a network on disk is mapped read-only and
+// shared by every LP without being parsed or copied. The file is
+//
+//   header       a RoadNetworkHeader
+//   first_road   num_nodes + 1 uint64, the roads leaving node n are
+//                [first_road[n], first_road[n + 1])
+//   target       num_roads uint32, the node each road leads to
+//   length       num_roads uint32, the length of each road
+//   capacity     num_roads uint32, the cars each lane of a road holds
+//
+// with each array padded to a multiple of 8 bytes. All numbers are in host
+// byte order. tools/road_network_convert builds a file from a text edge list.
+
+const char kRoadNetworkMagic[8] = {'W', 'M', 'R', 'O', 'A', 'D', 'S', '1'};
+
+struct RoadNetworkHeader {
+    char magic_[8];
+    std::uint64_t num_nodes_;
+    std::uint64_t num_roads_;
+};
+
+class RoadNetwork {
+public:
+    struct Road {
+        std::uint32_t from_;
+        std::uint32_t to_;
+        std::uint32_t length_;
+        std::uint32_t capacity_;
+    };
+
+    RoadNetwork() = default;
+    RoadNetwork(const RoadNetwork&) = delete;
+    RoadNetwork& operator=(const RoadNetwork&) = delete;
+    RoadNetwork(RoadNetwork&& other) { *this = std::move(other); }
+
+    RoadNetwork& operator=(RoadNetwork&& other) {
+        if (this != &other) {
+            unmap();
+            image_ = std::move(other.image_);
+            mapped_ = other.mapped_;
+            mapped_size_ = other.mapped_size_;
+            other.mapped_ = nullptr;
+            other.mapped_size_ = 0;
+            attach(mapped_ ? mapped_ : reinterpret_cast<const char*>(image_.data()));
+        }
+        return *this;
+    }
+
+    ~RoadNetwork() { unmap(); }
+
+    // Builds a network in memory from roads given in any order. Returns an
+    // empty network if a road leaves or enters a node past 'num_nodes'.
+    static RoadNetwork fromRoads(std::uint32_t num_nodes, const std::vector<Road>& roads) {
+        RoadNetwork network;
+        for (auto& road : roads) {
+            if ((road.from_ >= num_nodes) || (road.to_ >= num_nodes)) return network;
+        }
+
+        // Counting sort by source node, keeping the given order within a node
+        std::vector<std::uint64_t> first_road((std::uint64_t) num_nodes + 1, 0);
+        for (auto& road : roads) {
+            first_road[road.from_ + 1]++;
+        }
+        for (std::uint32_t node = 0; node < num_nodes; node++) {
+            first_road[node + 1] += first_road[node];
+        }
+        std::vector<std::uint64_t> next(first_road.begin(), first_road.end() - 1);
+
+        network.image_.assign(imageSize(num_nodes, roads.size()) / 8, 0);
+        char* base = reinterpret_cast<char*>(network.image_.data());
+        RoadNetworkHeader* header = reinterpret_cast<RoadNetworkHeader*>(base);
+        std::memcpy(header->magic_, kRoadNetworkMagic, sizeof kRoadNetworkMagic);
+        header->num_nodes_ = num_nodes;
+        header->num_roads_ = roads.size();
+        network.attach(base);
+
+        // The image is ours to fill in
+        std::uint32_t* target = const_cast<std::uint32_t*>(network.target_);
+        std::uint32_t* length = const_cast<std::uint32_t*>(network.length_);
+        std::uint32_t* capacity = const_cast<std::uint32_t*>(network.capacity_);
+        std::memcpy(const_cast<std::uint64_t*>(network.first_road_), first_road.data(),
+                                            first_road.size() * sizeof(std::uint64_t));
+        for (auto& road : roads) {
+            std::uint64_t slot = next[road.from_]++;
+            target[slot] = road.to_;
+            length[slot] = road.length_;
+            capacity[slot] = road.capacity_;
+        }
+        return network;
+    }
+
+    // A road for every direction of every grid cell, in direction order
+    template <typename Layout, bool Wrap>
+    static RoadNetwork fromGrid(const GridTopology<Layout, Wrap>& grid,
+                                    std::uint32_t length, std::uint32_t capacity) {
+        std::vector<Road> roads;
+        roads.reserve((std::uint64_t) grid.size() * Layout::kDegree);
+        for (std::uint32_t node = 0; node < grid.size(); node++) {
+            for (unsigned int dir = 0; dir < Layout::kDegree; dir++) {
+                roads.push_back(Road {node, grid.neighbour(node, dir), length, capacity});
+            }
+        }
+        return fromRoads(grid.size(), roads);
+    }
+
+    // Maps a network file read-only. Returns false if the file is missing or
+    // is not a complete and consistent road network.
+    bool open(const std::string& filename) {
+        *this = RoadNetwork();
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if ((::fstat(fd, &st) != 0) || ((std::uint64_t) st.st_size < sizeof(RoadNetworkHeader))) {
+            ::close(fd);
+            return false;
+        }
+        void* base = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) return false;
+        mapped_ = static_cast<const char*>(base);
+        mapped_size_ = st.st_size;
+
+        const RoadNetworkHeader* header = reinterpret_cast<const RoadNetworkHeader*>(mapped_);
+        if (std::memcmp(header->magic_, kRoadNetworkMagic, sizeof kRoadNetworkMagic) ||
+                (header->num_nodes_ >= UINT32_MAX) || (header->num_roads_ >= UINT32_MAX) ||
+                (imageSize(header->num_nodes_, header->num_roads_) != mapped_size_)) {
+            *this = RoadNetwork();
+            return false;
+        }
+        attach(mapped_);
+
+        bool valid = (first_road_[0] == 0) && (first_road_[num_nodes_] == num_roads_);
+        for (std::uint64_t node = 0; valid && (node < num_nodes_); node++) {
+            valid = first_road_[node] <= first_road_[node + 1];
+        }
+        for (std::uint64_t road = 0; valid && (road < num_roads_); road++) {
+            valid = target_[road] < num_nodes_;
+        }
+        if (!valid) {
+            *this = RoadNetwork();
+        }
+        return valid;
+    }
+
+    // Returns false if the file could not be written
+    bool write(const std::string& filename) const {
+        const char* base = mapped_ ? mapped_ : reinterpret_cast<const char*>(image_.data());
+        if (!base) return false;
+        std::FILE* file = std::fopen(filename.c_str(), "wb");
+        if (!file) return false;
+        std::uint64_t size = imageSize(num_nodes_, num_roads_);
+        bool written = (std::fwrite(base, 1, size, file) == size);
+        return (std::fclose(file) == 0) && written;
+    }
+
+    bool empty() const { return !first_road_; }
+    std::uint32_t numNodes() const { return num_nodes_; }
+    std::uint32_t numRoads() const { return num_roads_; }
+
+    // Roads leaving 'node' are numbered firstRoad(node) to firstRoad(node + 1) - 1
+    std::uint32_t firstRoad(std::uint32_t node) const { return first_road_[node]; }
+    std::uint32_t degree(std::uint32_t node) const {
+        return first_road_[node + 1] - first_road_[node];
+    }
+
+    std::uint32_t target(std::uint32_t road) const { return target_[road]; }
+    std::uint32_t length(std::uint32_t road) const { return length_[road]; }
+    std::uint32_t capacity(std::uint32_t road) const { return capacity_[road]; }
+
+private:
+    static std::uint64_t padded(std::uint64_t size) { return (size + 7) & ~(std::uint64_t) 7; }
+
+    static std::uint64_t imageSize(std::uint64_t num_nodes, std::uint64_t num_roads) {
+        return sizeof(RoadNetworkHeader) + (num_nodes + 1) * sizeof(std::uint64_t) +
+                    3 * padded(num_roads * sizeof(std::uint32_t));
+    }
+
+    // Points the arrays into an image whose header is filled in
+    void attach(const char* base) {
+        if (!base) {
+            num_nodes_ = num_roads_ = 0;
+            first_road_ = nullptr;
+            target_ = length_ = capacity_ = nullptr;
+            return;
+        }
+        const RoadNetworkHeader* header = reinterpret_cast<const RoadNetworkHeader*>(base);
+        num_nodes_ = header->num_nodes_;
+        num_roads_ = header->num_roads_;
+        std::uint64_t road_bytes = padded(num_roads_ * sizeof(std::uint32_t));
+        const char* arrays = base + sizeof(RoadNetworkHeader);
+        first_road_ = reinterpret_cast<const std::uint64_t*>(arrays);
+        arrays += (num_nodes_ + 1) * sizeof(std::uint64_t);
+        target_ = reinterpret_cast<const std::uint32_t*>(arrays);
+        length_ = reinterpret_cast<const std::uint32_t*>(arrays + road_bytes);
+        capacity_ = reinterpret_cast<const std::uint32_t*>(arrays + 2 * road_bytes);
+    }
+
+    void unmap() {
+        if (mapped_) ::munmap(const_cast<char*>(mapped_), mapped_size_);
+        mapped_ = nullptr;
+        mapped_size_ = 0;
+    }
+
+    // Either an image built in memory or a mapped file
+    std::vector<std::uint64_t> image_;
+    const char* mapped_ = nullptr;
+    std::uint64_t mapped_size_ = 0;
+
+    std::uint32_t num_nodes_ = 0;
+    std::uint32_t num_roads_ = 0;
+    const std::uint64_t* first_road_ = nullptr;
+    const std::uint32_t* target_ = nullptr;
+    const std::uint32_t* length_ = nullptr;
+    const std::uint32_t* capacity_ = nullptr;
+};
+
+#endif
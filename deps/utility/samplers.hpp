@@ -0,0 +1,389 @@
+#ifndef WARPED_MODELS_UTILITY_SAMPLERS_HPP
+#define WARPED_MODELS_UTILITY_SAMPLERS_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Random variate samplers for event delays, meant to be built once per LP
+// instead of constructing a <random> distribution on every event.
+//
+// Unlike some <random> distributions (std::normal_distribution keeps the
+// second value of each pair), the samplers hold no state that changes while
+// sampling: every variate is a pure function of the words drawn from the
+// engine. Rolling back the engine registered with registerRNG() is therefore
+// enough to replay the exact same variates.
+//
+// The engine must produce uniform 32-bit words, e.g. Philox4x32.
+
+namespace sampler_detail {
+
+const double kTwoPow24 = 16777216.0;
+const double kTwoPow32Inv = 1.0 / 4294967296.0;
+
+// Uniform double in (0, 1), safe to take the log of
+template <typename URNG>
+inline double openUnit(URNG& rng) {
+    return (rng() + 0.5) * kTwoPow32Inv;
+}
+
+// Ziggurat tables from "The Ziggurat Method for Generating Random Variables"
+// by Marsaglia and Tsang (2000). Each draw uses its low bits to pick a layer
+// and its high 24 bits as the position within the layer, so that the two are
+// independent.
+struct ExponentialZiggurat {
+    static const unsigned int kLayers = 256;
+    static constexpr double kR = 7.697117470131487;
+    static constexpr double kArea = 3.949659822581572e-3;
+
+    std::uint32_t k_[kLayers];
+    double w_[kLayers];
+    double f_[kLayers];
+
+    ExponentialZiggurat() {
+        double de = kR, te = kR;
+        double q = kArea / std::exp(-de);
+        k_[0] = (std::uint32_t) ((de / q) * kTwoPow24);
+        k_[1] = 0;
+        w_[0] = q / kTwoPow24;
+        w_[kLayers-1] = de / kTwoPow24;
+        f_[0] = 1.0;
+        f_[kLayers-1] = std::exp(-de);
+        for (unsigned int i = kLayers - 2; i >= 1; i--) {
+            de = -std::log(kArea / de + std::exp(-de));
+            k_[i+1] = (std::uint32_t) ((de / te) * kTwoPow24);
+            te = de;
+            f_[i] = std::exp(-de);
+            w_[i] = de / kTwoPow24;
+        }
+    }
+
+    static const ExponentialZiggurat& get() {
+        static const ExponentialZiggurat table;
+        return table;
+    }
+
+    template <typename URNG>
+    double sample(URNG& rng) const {
+        for (;;) {
+            std::uint32_t u = rng();
+            unsigned int i = u & (kLayers - 1);
+            std::uint32_t j = u >> 8;
+            double x = j * w_[i];
+            if (j < k_[i]) return x;
+            if (i == 0) return kR - std::log(openUnit(rng));
+            if (f_[i] + openUnit(rng) * (f_[i-1] - f_[i]) < std::exp(-x)) return x;
+        }
+    }
+};
+
+struct NormalZiggurat {
+    static const unsigned int kLayers = 128;
+    static constexpr double kR = 3.442619855899;
+    static constexpr double kArea = 9.91256303526217e-3;
+
+    std::uint32_t k_[kLayers];
+    double w_[kLayers];
+    double f_[kLayers];
+
+    NormalZiggurat() {
+        double dn = kR, tn = kR;
+        double q = kArea / std::exp(-0.5 * dn * dn);
+        k_[0] = (std::uint32_t) ((dn / q) * kTwoPow24);
+        k_[1] = 0;
+        w_[0] = q / kTwoPow24;
+        w_[kLayers-1] = dn / kTwoPow24;
+        f_[0] = 1.0;
+        f_[kLayers-1] = std::exp(-0.5 * dn * dn);
+        for (unsigned int i = kLayers - 2; i >= 1; i--) {
+            dn = std::sqrt(-2.0 * std::log(kArea / dn + std::exp(-0.5 * dn * dn)));
+            k_[i+1] = (std::uint32_t) ((dn / tn) * kTwoPow24);
+            tn = dn;
+            f_[i] = std::exp(-0.5 * dn * dn);
+            w_[i] = dn / kTwoPow24;
+        }
+    }
+
+    static const NormalZiggurat& get() {
+        static const NormalZiggurat table;
+        return table;
+    }
+
+    // Bit 7 of the draw is the sign
+    template <typename URNG>
+    double sample(URNG& rng) const {
+        for (;;) {
+            std::uint32_t u = rng();
+            unsigned int i = u & (kLayers - 1);
+            bool negative = u & kLayers;
+            std::uint32_t j = u >> 8;
+            double x = j * w_[i];
+            if (j < k_[i]) return negative ? -x : x;
+            if (i == 0) {
+                double y;
+                do {
+                    x = -std::log(openUnit(rng)) / kR;
+                    y = -std::log(openUnit(rng));
+                } while (y + y < x * x);
+                return negative ? -(kR + x) : kR + x;
+            }
+            if (f_[i] + openUnit(rng) * (f_[i-1] - f_[i]) < std::exp(-0.5 * x * x)) {
+                return negative ? -x : x;
+            }
+        }
+    }
+};
+
+// Inverse-CDF table of a Poisson distribution with a guide table ("indexed
+// search", Chen and Asau 1974), so that a sample is one draw, one guide lookup
+// and on average about one comparison. The table covers the mean +/- 12
+// standard deviations; the mass outside is far below the 2^-32 resolution of
+// a draw.
+class PoissonTable {
+public:
+    explicit PoissonTable(double mean) {
+        if (mean <= 0.0) {
+            cdf_.push_back(1.0);
+            guide_.push_back(0);
+            return;
+        }
+        double spread = 12.0 * std::sqrt(mean) + 12.0;
+        double low = std::floor(mean - spread);
+        first_ = (low > 0.0) ? (unsigned int) low : 0;
+        unsigned int last = (unsigned int) std::ceil(mean + spread);
+
+        double log_mean = std::log(mean);
+        double total = 0.0;
+        for (unsigned int k = first_; k <= last; k++) {
+            total += std::exp(k * log_mean - mean - std::lgamma(k + 1.0));
+            cdf_.push_back(total);
+        }
+        for (auto& p : cdf_) {
+            p /= total;
+        }
+        cdf_.back() = 1.0;
+
+        guide_.resize(cdf_.size());
+        unsigned int i = 0;
+        for (unsigned int g = 0; g < guide_.size(); g++) {
+            while (cdf_[i] <= (double) g / guide_.size()) i++;
+            guide_[g] = i;
+        }
+    }
+
+    template <typename URNG>
+    unsigned int sample(URNG& rng) const {
+        double u = rng() * kTwoPow32Inv;
+        unsigned int i = guide_[(std::size_t) (u * guide_.size())];
+        while (cdf_[i] <= u) i++;
+        return first_ + i;
+    }
+
+    // Tables are shared by every sampler with the same mean
+    static std::shared_ptr<const PoissonTable> get(double mean) {
+        static std::mutex mutex;
+        static std::map<double, std::shared_ptr<const PoissonTable>> tables;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& table = tables[mean];
+        if (!table) {
+            table = std::make_shared<const PoissonTable>(mean);
+        }
+        return table;
+    }
+
+private:
+    unsigned int first_ = 0;
+    std::vector<double> cdf_;
+    std::vector<unsigned int> guide_;
+};
+
+} // namespace sampler_detail
+
+// Integers uniform in [low, high], by Lemire's multiply-and-shift method, which
+// only divides when a draw must be rejected
+class UniformIntSampler {
+public:
+    UniformIntSampler(std::int64_t low, std::int64_t high)
+        : low_(low), range_((std::uint64_t) (high - low) + 1) {}
+
+    template <typename URNG>
+    std::int64_t operator()(URNG& rng) const {
+        if (range_ > 0xFFFFFFFF) {
+            return low_ + rng();
+        }
+        std::uint32_t range = (std::uint32_t) range_;
+        std::uint64_t m = (std::uint64_t) rng() * range;
+        if ((std::uint32_t) m < range) {
+            std::uint32_t threshold = (0u - range) % range;
+            while ((std::uint32_t) m < threshold) {
+                m = (std::uint64_t) rng() * range;
+            }
+        }
+        return low_ + (std::int64_t) (m >> 32);
+    }
+
+private:
+    std::int64_t low_;
+    std::uint64_t range_;
+};
+
+// Doubles uniform in [low, high)
+class UniformRealSampler {
+public:
+    UniformRealSampler(double low, double high) : low_(low), scale_(high - low) {}
+
+    template <typename URNG>
+    double operator()(URNG& rng) const {
+        return low_ + scale_ * (rng() * sampler_detail::kTwoPow32Inv);
+    }
+
+private:
+    double low_;
+    double scale_;
+};
+
+class ExponentialSampler {
+public:
+    explicit ExponentialSampler(double mean)
+        : mean_(mean), table_(&sampler_detail::ExponentialZiggurat::get()) {}
+
+    template <typename URNG>
+    double operator()(URNG& rng) const {
+        return mean_ * table_->sample(rng);
+    }
+
+private:
+    double mean_;
+    const sampler_detail::ExponentialZiggurat* table_;
+};
+
+class NormalSampler {
+public:
+    NormalSampler(double mean, double stddev)
+        : mean_(mean), stddev_(stddev), table_(&sampler_detail::NormalZiggurat::get()) {}
+
+    template <typename URNG>
+    double operator()(URNG& rng) const {
+        return mean_ + stddev_ * table_->sample(rng);
+    }
+
+private:
+    double mean_;
+    double stddev_;
+    const sampler_detail::NormalZiggurat* table_;
+};
+
+class PoissonSampler {
+public:
+    explicit PoissonSampler(double mean) : table_(sampler_detail::PoissonTable::get(mean)) {}
+
+    template <typename URNG>
+    unsigned int operator()(URNG& rng) const {
+        return table_->sample(rng);
+    }
+
+private:
+    std::shared_ptr<const sampler_detail::PoissonTable> table_;
+};
+
+namespace sampler_detail {
+
+// Walker's alias method, built in O(n) as in "A Linear Algorithm for
+// Generating Random Numbers with a Given Distribution" by M.D. Vose (1991). A
+// sample picks one of the n columns uniformly and then either the column
+// itself or its alias, so it costs the same at any n. Each column is eight
+// bytes.
+class AliasTable {
+public:
+    explicit AliasTable(const std::vector<double>& weights) 
+            : columns_(0, weights.empty() ? 0 : (std::int64_t) weights.size() - 1), 
+              threshold_(weights.empty() ? 1 : weights.size(), 0xFFFFFFFF), 
+              alias_(threshold_.size()) {
+        std::size_t n = threshold_.size();
+        double total = 0.0;
+        for (double w : weights) {
+            total += w;
+        }
+        if (weights.empty() || (total <= 0.0)) {
+            for (std::size_t i = 0; i < n; i++) alias_[i] = (std::uint32_t) i;
+            return;
+        }
+
+        // Scaled so that a column holds probability 1
+        std::vector<double> scaled(n);
+        std::vector<std::uint32_t> small, large;
+        for (std::size_t i = 0; i < n; i++) {
+            scaled[i] = weights[i] * n / total;
+            (scaled[i] < 1.0 ? small : large).push_back((std::uint32_t) i);
+        }
+        while (!small.empty() && !large.empty()) {
+            std::uint32_t s = small.back(), l = large.back();
+            small.pop_back();
+            threshold_[s] = (std::uint32_t) (scaled[s] * 4294967295.0);
+            alias_[s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // Whatever is left is 1 up to rounding
+        for (auto i : small) alias_[i] = i;
+        for (auto i : large) alias_[i] = i;
+    }
+
+    template <typename URNG>
+    std::uint32_t sample(URNG& rng) const {
+        std::uint32_t column = (std::uint32_t) columns_(rng);
+        return (rng() <= threshold_[column]) ? column : alias_[column];
+    }
+
+private:
+    UniformIntSampler columns_;
+    std::vector<std::uint32_t> threshold_;
+    std::vector<std::uint32_t> alias_;
+};
+
+// Alias table of ranks 0..n-1 with weight 1 / (rank + 1)^exponent
+inline std::shared_ptr<const AliasTable> zipfTable(std::uint32_t n, double exponent) {
+    static std::mutex mutex;
+    static std::map<std::pair<std::uint32_t, double>, std::shared_ptr<const AliasTable>> tables;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& table = tables[std::make_pair(n, exponent)];
+    if (!table) {
+        std::vector<double> weights(n);
+        for (std::uint32_t rank = 0; rank < n; rank++) {
+            weights[rank] = std::pow(rank + 1.0, -exponent);
+        }
+        table = std::make_shared<const AliasTable>(weights);
+    }
+    return table;
+}
+
+} // namespace sampler_detail
+
+// Ranks in [0, n) following Zipf's law, rank k with probability proportional
+// to 1 / (k + 1)^exponent. Tables are shared by every sampler with the same
+// n and exponent.
+class ZipfSampler {
+public:
+    ZipfSampler(std::uint32_t n, double exponent) 
+        : table_(sampler_detail::zipfTable(n, exponent)) {}
+
+    template <typename URNG>
+    std::uint32_t operator()(URNG& rng) const {
+        return table_->sample(rng);
+    }
+
+private:
+    std::shared_ptr<const sampler_detail::AliasTable> table_;
+};
+
+#endif
@@ -0,0 +1,349 @@
+#ifndef WARPED_MODELS_UTILITY_TRACE_HPP
+#define WARPED_MODELS_UTILITY_TRACE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cereal/archives/binary.hpp"
+
+// Binary trace of the events processed by a model's LPs, written by the
+// models' --trace option and read by bench/trace_replay. The file is
+//
+//   header       a TraceFileHeader
+//   params       params_size bytes of "key=value" lines, the parameters the
+//                LPs were built with, padded to a multiple of 8 bytes
+//   records      data_size bytes of back-to-back records, each a
+//                TraceRecordHeader followed by the event's cereal binary
+//                serialization, padded to a multiple of 8 bytes
+//
+// All numbers are in host byte order. Records are in the order the LPs
+// processed them. Under the Time Warp kernel that includes events that are
+// later rolled back; run the kernel sequentially for a trace of committed
+// events only.
+
+const char kTraceMagic[8] = {'W', 'M', 'T', 'R', 'A', 'C', 'E', '2'};
+
+struct TraceFileHeader {
+    char magic_[8];
+    // Both are zero until the writer is closed
+    std::uint64_t data_size_;
+    std::uint64_t num_records_;
+    std::uint64_t params_size_;
+    // NUL-terminated model name, e.g. "phold"
+    char model_[32];
+};
+
+struct TraceRecordHeader {
+    std::uint32_t receiver_;
+    std::uint32_t timestamp_;
+    std::uint32_t type_;
+    std::uint32_t payload_size_;
+};
+
+namespace trace_detail {
+
+inline std::uint64_t padded(std::uint64_t size) {
+    return (size + 7) & ~(std::uint64_t) 7;
+}
+
+// Output stream appending to a reusable buffer
+class AppendBuffer : public std::streambuf {
+public:
+    std::vector<char> bytes_;
+
+protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) bytes_.push_back((char) c);
+        return c;
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        bytes_.insert(bytes_.end(), s, s + n);
+        return n;
+    }
+};
+
+// Input stream over a record's payload, in place
+class PayloadBuffer : public std::streambuf {
+public:
+    void reset(const char* data, std::size_t size) {
+        char* begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+};
+
+} // namespace trace_detail
+
+// Appends records to a trace through a shared memory mapping. Any number of
+// worker threads may call record() at once: a record's place in the file is
+// claimed with one atomic add and it is then copied straight into the mapping.
+// The file is grown in 64 MiB steps under a lock, inside an address range
+// reserved up front so that the mapping never moves.
+class TraceWriter {
+public:
+    static const std::uint64_t kGrowBytes = 64ull << 20;
+
+    TraceWriter() = default;
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+    ~TraceWriter() { close(); }
+
+    // Returns false if the file could not be created and mapped, or if the
+    // model name is too long or a parameter has a newline in it. 'max_bytes'
+    // caps the size of the trace; records beyond it are dropped and counted.
+    bool open(const std::string& filename, const std::string& model,
+                const std::map<std::string, std::string>& params,
+                std::uint64_t max_bytes = 1ull << 40) {
+        std::string lines;
+        for (auto& param : params) {
+            if ((param.first + param.second).find('\n') != std::string::npos) return false;
+            lines += param.first + "=" + param.second + "\n";
+        }
+        if (model.size() >= sizeof(TraceFileHeader::model_)) return false;
+
+        fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) return false;
+
+        void* base = MAP_FAILED;
+        for (reserved_ = max_bytes; reserved_ >= kGrowBytes; reserved_ /= 2) {
+            base = ::mmap(nullptr, reserved_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            if (base != MAP_FAILED) break;
+        }
+        if ((base == MAP_FAILED) || (::ftruncate(fd_, kGrowBytes) != 0)) {
+            if (base != MAP_FAILED) ::munmap(base, reserved_);
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        base_ = static_cast<char*>(base);
+        file_size_ = kGrowBytes;
+        limit_ = reserved_;
+        data_start_ = sizeof(TraceFileHeader) + trace_detail::padded(lines.size());
+        next_ = data_start_;
+        end_ = reserved_;
+        if (!reserve(data_start_)) {
+            ::munmap(base_, reserved_);
+            ::close(fd_);
+            base_ = nullptr;
+            fd_ = -1;
+            return false;
+        }
+
+        TraceFileHeader* header = reinterpret_cast<TraceFileHeader*>(base_);
+        std::memcpy(header->magic_, kTraceMagic, sizeof kTraceMagic);
+        header->params_size_ = lines.size();
+        std::memcpy(header->model_, model.c_str(), model.size() + 1);
+        std::memcpy(base_ + sizeof(TraceFileHeader), lines.data(), lines.size());
+        return true;
+    }
+
+    bool isOpen() const { return base_ != nullptr; }
+
+    // Serializes the event as processed by LP 'receiver'
+    template <typename EventType>
+    void record(std::uint32_t receiver, std::uint32_t type, const EventType& event) {
+        struct Serializer {
+            trace_detail::AppendBuffer buffer_;
+            std::ostream stream_ {&buffer_};
+            cereal::BinaryOutputArchive archive_ {stream_};
+        };
+        static thread_local Serializer serializer;
+
+        serializer.buffer_.bytes_.clear();
+        serializer.archive_(event);
+        const std::vector<char>& payload = serializer.buffer_.bytes_;
+
+        TraceRecordHeader record {receiver, event.timestamp(), type,
+                                    (std::uint32_t) payload.size()};
+        std::uint64_t size = trace_detail::padded(sizeof record + payload.size());
+        std::uint64_t offset = next_.fetch_add(size, std::memory_order_relaxed);
+        if (!reserve(offset + size)) {
+            drop(offset);
+            return;
+        }
+        std::memcpy(base_ + offset, &record, sizeof record);
+        std::memcpy(base_ + offset + sizeof record, payload.data(), payload.size());
+        num_records_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Records that did not fit under the size cap or on the disk
+    std::uint64_t numDropped() const { return num_dropped_.load(); }
+
+    // Fills in the header and trims the file to the records written. Must not
+    // race with record(). Returns false if the file could not be trimmed.
+    bool close() {
+        if (!base_) return true;
+        std::uint64_t end = std::min(next_.load(), end_.load());
+        TraceFileHeader* header = reinterpret_cast<TraceFileHeader*>(base_);
+        header->data_size_ = end - data_start_;
+        header->num_records_ = num_records_.load();
+        ::munmap(base_, reserved_);
+        bool trimmed = (::ftruncate(fd_, end) == 0);
+        ::close(fd_);
+        base_ = nullptr;
+        fd_ = -1;
+        return trimmed;
+    }
+
+private:
+    // Makes sure the file reaches 'size' bytes
+    bool reserve(std::uint64_t size) {
+        if (size <= file_size_.load(std::memory_order_acquire)) return true;
+        if (size > limit_.load(std::memory_order_relaxed)) return false;
+
+        std::lock_guard<std::mutex> lock(grow_mutex_);
+        std::uint64_t file_size = file_size_.load(std::memory_order_relaxed);
+        if (size <= file_size) return true;
+        std::uint64_t new_size = std::max(size, 2 * file_size);
+        new_size = std::min((new_size + kGrowBytes - 1) / kGrowBytes * kGrowBytes, reserved_);
+        if (::ftruncate(fd_, new_size) != 0) {
+            // Out of disk: nothing past the current end can be written
+            limit_.store(file_size, std::memory_order_relaxed);
+            return false;
+        }
+        file_size_.store(new_size, std::memory_order_release);
+        return true;
+    }
+
+    // Offsets are handed out in increasing order, so the first dropped record
+    // marks the end of the trace
+    void drop(std::uint64_t offset) {
+        num_dropped_.fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t end = end_.load(std::memory_order_relaxed);
+        while ((offset < end) && !end_.compare_exchange_weak(end, offset)) {}
+    }
+
+    int fd_ = -1;
+    char* base_ = nullptr;
+    std::uint64_t reserved_ = 0;
+    std::uint64_t data_start_ = 0;
+    std::atomic<std::uint64_t> limit_ {0};
+    std::atomic<std::uint64_t> file_size_ {0};
+    std::atomic<std::uint64_t> next_ {0};
+    std::atomic<std::uint64_t> end_ {0};
+    std::atomic<std::uint64_t> num_records_ {0};
+    std::atomic<std::uint64_t> num_dropped_ {0};
+    std::mutex grow_mutex_;
+};
+
+// A record as it sits in the mapped trace
+struct TraceRecord {
+    std::uint32_t receiver_;
+    std::uint32_t timestamp_;
+    std::uint32_t type_;
+    std::uint32_t payload_size_;
+    const char* payload_;
+};
+
+// Maps a whole trace read-only and walks its records in order
+class TraceReader {
+public:
+    TraceReader() = default;
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+    ~TraceReader() {
+        if (base_) ::munmap(const_cast<char*>(base_), size_);
+    }
+
+    // Returns false if the file is missing, unfinished or not a trace
+    bool open(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if ((::fstat(fd, &st) != 0) || ((std::uint64_t) st.st_size < sizeof(TraceFileHeader))) {
+            ::close(fd);
+            return false;
+        }
+        size_ = st.st_size;
+        void* base = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) return false;
+        base_ = static_cast<const char*>(base);
+        ::madvise(base, size_, MADV_SEQUENTIAL);
+
+        const TraceFileHeader* header = reinterpret_cast<const TraceFileHeader*>(base_);
+        std::uint64_t available = size_ - sizeof(TraceFileHeader);
+        if (std::memcmp(header->magic_, kTraceMagic, sizeof kTraceMagic) ||
+                (trace_detail::padded(header->params_size_) > available) ||
+                (header->data_size_ > available - trace_detail::padded(header->params_size_))) {
+            return false;
+        }
+        model_.assign(header->model_, strnlen(header->model_, sizeof header->model_));
+        std::istringstream lines(std::string(base_ + sizeof(TraceFileHeader), 
+                                                                    header->params_size_));
+        std::string line;
+        while (std::getline(lines, line)) {
+            std::string::size_type equals = line.find('=');
+            if (equals != std::string::npos) {
+                params_[line.substr(0, equals)] = line.substr(equals + 1);
+            }
+        }
+        num_records_ = header->num_records_;
+        data_start_ = sizeof(TraceFileHeader) + trace_detail::padded(header->params_size_);
+        end_ = data_start_ + header->data_size_;
+        rewind();
+        return true;
+    }
+
+    const std::string& model() const { return model_; }
+    const std::map<std::string, std::string>& params() const { return params_; }
+    std::uint64_t numRecords() const { return num_records_; }
+
+    // The parameter's value, or 'fallback' if the trace does not have it
+    std::string param(const std::string& key, const std::string& fallback = "") const {
+        auto it = params_.find(key);
+        return (it != params_.end()) ? it->second : fallback;
+    }
+
+    void rewind() { position_ = data_start_; }
+
+    // Returns false at the end of the trace
+    bool next(TraceRecord& record) {
+        TraceRecordHeader header;
+        if (position_ + sizeof header > end_) return false;
+        std::memcpy(&header, base_ + position_, sizeof header);
+        if (position_ + sizeof header + header.payload_size_ > end_) return false;
+        record = TraceRecord {header.receiver_, header.timestamp_, header.type_,
+                                header.payload_size_, base_ + position_ + sizeof header};
+        position_ += trace_detail::padded(sizeof header + header.payload_size_);
+        return true;
+    }
+
+    // Deserializes a record's payload into 'event'
+    template <typename EventType>
+    void decode(const TraceRecord& record, EventType& event) {
+        buffer_.reset(record.payload_, record.payload_size_);
+        stream_.clear();
+        archive_(event);
+    }
+
+private:
+    const char* base_ = nullptr;
+    std::uint64_t size_ = 0;
+    std::uint64_t data_start_ = 0;
+    std::uint64_t end_ = 0;
+    std::uint64_t position_ = 0;
+    std::uint64_t num_records_ = 0;
+    std::string model_;
+    std::map<std::string, std::string> params_;
+
+    trace_detail::PayloadBuffer buffer_;
+    std::istream stream_ {&buffer_};
+    cereal::BinaryInputArchive archive_ {stream_};
+};
+
+#endif
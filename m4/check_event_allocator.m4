@@ -0,0 +1,23 @@
+dnl Select how model events are allocated
+
+dnl Usage: CHECK_EVENT_ALLOCATOR
+
+AC_DEFUN([CHECK_EVENT_ALLOCATOR],
+[
+    dnl pool   - std::allocate_shared from per-thread free lists (default)
+    dnl shared - std::make_shared from the global heap
+    dnl new    - raw new wrapped in std::shared_ptr
+    AC_ARG_WITH([event-allocator],
+                [AS_HELP_STRING([--with-event-allocator=pool|shared|new], [how model events are allocated (default: pool)])],
+                [],
+                [with_event_allocator=pool])
+
+    AS_CASE([$with_event_allocator],
+            [pool], [CPPFLAGS="$CPPFLAGS -DWARPED_MODELS_EVENT_ALLOCATOR_POOL"],
+            [shared], [CPPFLAGS="$CPPFLAGS -DWARPED_MODELS_EVENT_ALLOCATOR_SHARED"],
+            [new], [CPPFLAGS="$CPPFLAGS -DWARPED_MODELS_EVENT_ALLOCATOR_NEW"],
+            [AC_MSG_ERROR([Invalid event allocator $with_event_allocator. Use pool, shared or new])])
+
+    AC_MSG_RESULT([Model events are allocated with: $with_event_allocator])
+
+]) dnl end CHECK_EVENT_ALLOCATOR
@@ -0,0 +1,19 @@
+dnl Select whether model event handlers are profiled
+
+dnl Usage: CHECK_EVENT_PROFILE
+
+AC_DEFUN([CHECK_EVENT_PROFILE],
+[
+    dnl Counts, sampled cycles and fan-out per event type, printed per worker
+    dnl thread after the simulation (see deps/utility/event_profile.hpp)
+    AC_ARG_ENABLE([event-profile],
+                  [AS_HELP_STRING([--enable-event-profile], [profile model event handlers per event type (default: no)])],
+                  [],
+                  [enable_event_profile=no])
+
+    AS_IF([test "x$enable_event_profile" = xyes],
+          [CPPFLAGS="$CPPFLAGS -DWARPED_MODELS_EVENT_PROFILE"])
+
+    AC_MSG_RESULT([Model event handlers are profiled: $enable_event_profile])
+
+]) dnl end CHECK_EVENT_PROFILE
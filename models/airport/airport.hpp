@@ -10,21 +10,33 @@
 #include <random>
 
 #include "warped.hpp"
-
-WARPED_DEFINE_LP_STATE_STRUCT(AirportState) {
+#include "utility/event_profile.hpp"
+#include "utility/grid_topology.hpp"
+#include "utility/lp_names.hpp"
+#include "utility/philox.hpp"
+#include "utility/pod_state.hpp"
+#include "utility/samplers.hpp"
+#include "utility/trace.hpp"
+
+struct AirportCounters {
     unsigned int arrivals_;
     unsigned int departures_;
     unsigned int planes_grounded_;
+};
+
+WARPED_MODELS_ASSERT_POD_STATE(AirportCounters);
+
+WARPED_DEFINE_LP_STATE_STRUCT(AirportState), public AirportCounters {
 
     template <typename Archive>
     void save(Archive& ar) const {
       // Do not save the base class!
-      ar(arrivals_, departures_, planes_grounded_);
+      savePodState<AirportCounters>(ar, *this);
     }
     template <typename Archive>
     void load(Archive& ar) {
       // Do not load the base class!
-      ar(arrivals_, departures_, planes_grounded_);
+      loadPodState<AirportCounters>(ar, *this);
     }
 };
 
@@ -35,10 +47,10 @@ enum airport_event_t {
 
 enum direction_t {
 
-    LEFT,
-    RIGHT,
-    DOWN,
-    UP
+    LEFT    = SquareGrid2D::LEFT,
+    RIGHT   = SquareGrid2D::RIGHT,
+    DOWN    = SquareGrid2D::DOWN,
+    UP      = SquareGrid2D::UP
 };
 
 class AirportEvent : public warped::Event {
@@ -60,21 +72,22 @@ public:
 
 class Airport : public warped::LogicalProcess {
 public:
-    Airport(    const std::string& name, 
-                const unsigned int num_airports_x, 
-                const unsigned int num_airports_y, 
+    Airport(    const LPNameRegistry& lp_names, 
+                const Torus2D& grid, 
                 const unsigned int num_planes, 
                 const unsigned int arrive_mean, 
                 const unsigned int depart_mean, 
+                const std::uint64_t seed, 
                 const unsigned int index)
-        :   LogicalProcess(name), 
+        :   LogicalProcess(lp_names[index]), 
             state_(), 
-            rng_(new std::default_random_engine(index)),
-            num_airports_x_(num_airports_x), 
-            num_airports_y_(num_airports_y), 
+            lp_names_(lp_names), 
+            rng_(new Philox4x32(seed, index)),
+            grid_(grid), 
             num_planes_(num_planes), 
-            arrive_mean_(arrive_mean), 
-            depart_mean_(depart_mean), 
+            arrive_expo_(arrive_mean), 
+            depart_expo_(depart_mean), 
+            rand_direction_(0, Torus2D::kDegree-1), 
             index_(index) {
 
         state_.departures_      = 0;
@@ -86,21 +99,27 @@ public:
     virtual std::vector<std::shared_ptr<warped::Event> > receiveEvent(const warped::Event&);
     virtual warped::LPState& getState() { return this->state_; }
 
-    AirportState state_;
+    // Records every processed event to 'trace' from now on
+    void recordTo(TraceWriter* trace) { trace_ = trace; }
 
-    static inline std::string lp_name(const unsigned int);
+    AirportState state_;
 
 protected:
-    std::shared_ptr<std::default_random_engine> rng_;
-    const unsigned int num_airports_x_;
-    const unsigned int num_airports_y_;
+    const LPNameRegistry& lp_names_;
+    std::shared_ptr<Philox4x32> rng_;
+    const Torus2D& grid_;
     const unsigned int num_planes_;
-    const unsigned int arrive_mean_;
-    const unsigned int depart_mean_;
+    const ExponentialSampler arrive_expo_;
+    const ExponentialSampler depart_expo_;
+    const UniformIntSampler rand_direction_;
     const unsigned int index_;
+    TraceWriter* trace_ = nullptr;
 
-    std::string compute_move(direction_t direction);
-    std::string random_move();
+    const std::string& compute_move(direction_t direction);
+    const std::string& random_move();
 };
 
+typedef EventProfile<Airport, 2> AirportProfile;
+const char* const kAirportEventNames[] = {"ARRIVAL", "DEPARTURE"};
+
 #endif
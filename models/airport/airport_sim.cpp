@@ -0,0 +1,129 @@
+// An implementation of Fujimoto's airport model
+// Ported from the ROSS airport model (https://github.com/carothersc/ROSS/blob/master/ross/models/airport)
+
+#include <fstream>
+#include "airport.hpp"
+#include "utility/results.hpp"
+#include "tclap/ValueArg.h"
+
+int main(int argc, const char** argv) {
+
+    unsigned int num_airports_x     = 50;
+    unsigned int num_airports_y     = 50;
+    unsigned int mean_ground_time   = 50;
+    unsigned int mean_flight_time   = 200;
+    unsigned int num_planes         = 50;
+    unsigned long seed              = 0;
+    std::string results_filename    = "";
+    std::string trace_filename      = "";
+
+    TCLAP::ValueArg<unsigned int> num_airports_x_arg("x", "num-airports-x", "Width of airport grid",
+                                                            false, num_airports_x, "unsigned int");
+    TCLAP::ValueArg<unsigned int> num_airports_y_arg("y", "num-airports-y", "Height of airport grid",
+                                                            false, num_airports_y, "unsigned int");
+    TCLAP::ValueArg<unsigned int> mean_ground_time_arg("g", "ground-time", 
+                "Mean time of planes waiting to depart", false, mean_ground_time, "unsigned int");
+    TCLAP::ValueArg<unsigned int> mean_flight_time_arg("f", "flight-time", "Mean flight time",
+                                                        false, mean_flight_time, "unsigned int");
+    TCLAP::ValueArg<unsigned int> num_planes_arg("p", "num-planes", "Number of planes per airport",
+                                                                false, num_planes, "unsigned int");
+    TCLAP::ValueArg<unsigned long> seed_arg("", "seed", "Global seed of the per-airport random streams",
+                                                                false, seed, "unsigned long");
+    TCLAP::ValueArg<std::string> results_arg("", "results", 
+                "Columnar binary file to write each airport's final state to", 
+                                                        false, results_filename, "string");
+    TCLAP::ValueArg<std::string> trace_arg("", "trace", 
+                "Binary file to record every processed event to", false, trace_filename, "string");
+
+    std::vector<TCLAP::Arg*> args = {&num_airports_x_arg, &num_airports_y_arg, &mean_ground_time_arg, 
+                                &mean_flight_time_arg, &num_planes_arg, &seed_arg, &results_arg, 
+                                                                                &trace_arg};
+
+    warped::Simulation airport_sim {"Airport Simulation", argc, argv, args};
+
+    num_airports_x      = num_airports_x_arg.getValue();
+    num_airports_y      = num_airports_y_arg.getValue();
+    mean_ground_time    = mean_ground_time_arg.getValue();
+    mean_flight_time    = mean_flight_time_arg.getValue();
+    num_planes          = num_planes_arg.getValue();
+    seed                = seed_arg.getValue();
+    results_filename    = results_arg.getValue();
+    trace_filename      = trace_arg.getValue();
+
+    LPNameRegistry lp_names {"Airport_", num_airports_x*num_airports_y};
+    Torus2D grid {num_airports_x, num_airports_y};
+
+    std::vector<Airport> lps;
+
+    for (unsigned int i = 0; i < num_airports_x*num_airports_y; i++) {
+        lps.emplace_back(lp_names, grid, num_planes, mean_flight_time, mean_ground_time, seed, i);
+    }
+
+    TraceWriter trace;
+    if (!trace_filename.empty()) {
+        if (!trace.open(trace_filename, "airport", {
+                {"num-airports-x", std::to_string(num_airports_x)},
+                {"num-airports-y", std::to_string(num_airports_y)},
+                {"ground-time", std::to_string(mean_ground_time)},
+                {"flight-time", std::to_string(mean_flight_time)},
+                {"num-planes", std::to_string(num_planes)},
+                {"seed", std::to_string(seed)}})) {
+            std::cerr << "Could not create trace file - " << trace_filename << std::endl;
+            return 1;
+        }
+        for (auto& lp : lps) {
+            lp.recordTo(&trace);
+        }
+    }
+
+    std::vector<warped::LogicalProcess*> lp_pointers;
+    for (auto& lp : lps) {
+        lp_pointers.push_back(&lp);
+    }
+
+    auto status = airport_sim.simulate(lp_pointers);
+    AirportProfile::report("airport", kAirportEventNames);
+
+    if (trace.isOpen()) {
+        std::uint64_t dropped = trace.numDropped();
+        if (!trace.close() || dropped) {
+            std::cerr << "Trace file " << trace_filename << " is incomplete, " 
+                                    << dropped << " events not recorded" << std::endl;
+        }
+    }
+
+    unsigned int arrivals = 0;
+    unsigned int departures = 0;
+    unsigned int planes_grounded = 0;
+    for (auto& lp : lps) {
+        arrivals += lp.state_.arrivals_;
+        departures += lp.state_.departures_;
+        planes_grounded += lp.state_.planes_grounded_;
+    }
+    std::cout << departures << " total departures" << std::endl;
+    std::cout << arrivals << " total arrivals" << std::endl;
+    std::cout << planes_grounded << " of "  << num_airports_x*num_airports_y*num_planes 
+                                            << " planes grounded" << std::endl;
+
+    if (airport_sim.isMasterProcess() && !results_filename.empty()) {
+        ResultsWriter results {lps.size()};
+        results.addColumn<std::uint32_t>("arrivals", 
+                        [&](std::uint64_t i) { return lps[i].state_.arrivals_; });
+        results.addColumn<std::uint32_t>("departures", 
+                        [&](std::uint64_t i) { return lps[i].state_.departures_; });
+        results.addColumn<std::uint32_t>("planes_grounded", 
+                        [&](std::uint64_t i) { return lps[i].state_.planes_grounded_; });
+        if (!results.write(results_filename)) {
+            std::cerr << "Could not write results file - " << results_filename << std::endl;
+        }
+    }
+
+    // export termination status code to file
+    if (airport_sim.isMasterProcess()) {
+      std::ofstream ofs { "exit_status", std::ios_base::out | std::ios_base::trunc };
+      ofs << static_cast<int>(status);
+    }
+ 
+    return static_cast<int>(status);
+}
+
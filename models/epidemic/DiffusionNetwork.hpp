@@ -2,57 +2,68 @@
 #define DIFFUSION_NETWORK_HPP
 
 #include "memory.hpp"
+#include "utility/lp_names.hpp"
+#include "utility/philox.hpp"
+#include "utility/samplers.hpp"
 #include "Person.hpp"
 #include <random>
+#include <vector>
+#include <utility>
 
 class DiffusionNetwork {
 public:
 
     DiffusionNetwork(   unsigned int travel_time_to_hub,
-                        std::shared_ptr<std::default_random_engine> rng )
+                        std::shared_ptr<Philox4x32> rng )
         : travel_time_to_hub_(travel_time_to_hub), rng_(rng) {}
 
-    std::string pickLocation() {
+    // Index into the travel chart of a randomly picked location, or -1 if
+    // this location has no links
+    int pickLocation() {
 
-        std::string location_name = "";
+        int location_id = -1;
         unsigned int location_num = travel_time_chart_.size();
 
         if(location_num) {
-            std::uniform_int_distribution<int> distribution(0, location_num-1);
-            auto location_id = (unsigned int) distribution(*rng_);
-            auto map_iter = travel_time_chart_.begin();
-            for(unsigned int count = 0; count < location_id; count++) {
-                map_iter++;
-            }
-            location_name = map_iter->first;
+            UniformIntSampler distribution(0, location_num-1);
+            location_id = (int) distribution(*rng_);
         }
-        return location_name;
+        return location_id;
     }
 
-    unsigned int travelTimeToLocation(std::string location_name) {
+    const std::string& locationName(unsigned int location_id) {
 
-        return (travel_time_chart_[location_name] + travel_time_to_hub_);
+        return (*location_names_)[travel_time_chart_[location_id].first];
+    }
+
+    unsigned int travelTimeToLocation(unsigned int location_id) {
+
+        return (travel_time_chart_[location_id].second + travel_time_to_hub_);
     }
 
     unsigned int pickPerson(unsigned int person_count) {
 
         unsigned int person_id = 0;
         if(person_count) {
-            std::uniform_int_distribution<int> distribution(0, person_count-1);
-            person_id = (unsigned int) distribution(*rng_); 
+            UniformIntSampler distribution(0, person_count-1);
+            person_id = (unsigned int) distribution(*rng_);
         }
         return person_id;
     }
 
-    void populateTravelChart(std::map<std::string, unsigned int> travel_chart) {
+    // Travel chart entries are (location index, travel time to hub) pairs
+    void populateTravelChart(const LPNameRegistry& location_names,
+                    std::vector<std::pair<unsigned int, unsigned int>> travel_chart) {
 
+        location_names_ = &location_names;
         travel_time_chart_ = travel_chart;
     }
 
 private:
     unsigned int travel_time_to_hub_;
-    std::shared_ptr<std::default_random_engine> rng_;
-    std::map<std::string, unsigned int> travel_time_chart_;
+    std::shared_ptr<Philox4x32> rng_;
+    const LPNameRegistry* location_names_ = nullptr;
+    std::vector<std::pair<unsigned int, unsigned int>> travel_time_chart_;
 };
 
 #endif
@@ -4,12 +4,16 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <random>
 #include "memory.hpp"
 #include "warped.hpp"
 #include "Person.hpp"
 #include "DiseaseModel.hpp"
 #include "DiffusionNetwork.hpp"
+#include "utility/event_profile.hpp"
+#include "utility/philox.hpp"
+#include "utility/trace.hpp"
 
 WARPED_DEFINE_LP_STATE_STRUCT(LocationState) {
 
@@ -58,7 +62,7 @@ public:
 
     EpidemicEvent() = default;
 
-    EpidemicEvent(const std::string receiver_name, unsigned int timestamp, 
+    EpidemicEvent(const std::string& receiver_name, unsigned int timestamp, 
                             std::shared_ptr<Person> person, event_type_t event_type)
             : receiver_name_(receiver_name), loc_arrival_timestamp_(timestamp), 
                 event_type_(event_type) {
@@ -100,11 +104,11 @@ public:
                 float prob_uiv, float prob_uiu, unsigned int loc_state_refresh_interval, 
                 unsigned int loc_diffusion_trig_interval, 
                 std::vector<std::shared_ptr<Person>> population, 
-                unsigned int travel_time_to_hub, unsigned int index)
+                unsigned int travel_time_to_hub, std::uint64_t seed, unsigned int index)
             : LogicalProcess(name), state_(), location_name_(name), 
                 location_state_refresh_interval_(loc_state_refresh_interval), 
                 location_diffusion_trigger_interval_(loc_diffusion_trig_interval), 
-                rng_(new std::default_random_engine(index)) {
+                index_(index), rng_(new Philox4x32(seed, index)) {
 
         state_ = std::make_shared<LocationState>();
 
@@ -130,9 +134,10 @@ public:
 
     virtual std::vector<std::shared_ptr<warped::Event>> receiveEvent(const warped::Event& event);
 
-    void populateTravelDistances(std::map<std::string, unsigned int> travel_chart) {
+    void populateTravelDistances(const LPNameRegistry& location_names,
+                    std::vector<std::pair<unsigned int, unsigned int>> travel_chart) {
 
-        diffusion_network_->populateTravelChart(travel_chart);
+        diffusion_network_->populateTravelChart(location_names, travel_chart);
     }
 
     std::string getLocationName() {
@@ -140,6 +145,17 @@ public:
         return location_name_;
     }
 
+    const LocationState& getLocationState() const {
+
+        return *state_;
+    }
+
+    // Records every processed event to 'trace' from now on
+    void recordTo(TraceWriter* trace) {
+
+        trace_ = trace;
+    }
+
 protected:
 
     std::shared_ptr<LocationState> state_;
@@ -148,7 +164,19 @@ protected:
     std::shared_ptr<DiffusionNetwork> diffusion_network_;
     unsigned int location_state_refresh_interval_;
     unsigned int location_diffusion_trigger_interval_;
-    std::shared_ptr<std::default_random_engine> rng_;
+    unsigned int index_;
+    std::shared_ptr<Philox4x32> rng_;
+    TraceWriter* trace_ = nullptr;
 };
 
+typedef EventProfile<Location, 3> LocationProfile;
+const char* const kEpidemicEventNames[] = {"DISEASE_UPDATE_TRIGGER", "DIFFUSION_TRIGGER", 
+                                                                            "DIFFUSION"};
+
+// Builds the locations described by an epidemic config file (see config/) and
+// the registry of their names, which the locations refer to. Returns false if
+// the file cannot be opened.
+bool loadLocations(const std::string& config_filename, std::uint64_t seed, 
+                    std::vector<Location>& lps, std::unique_ptr<LPNameRegistry>& location_names);
+
 #endif
@@ -0,0 +1,201 @@
+#include <fstream>
+#include <map>
+#include <unordered_map>
+#include "epidemic.hpp"
+#include "WattsStrogatzModel.hpp"
+
+bool loadLocations(const std::string& config_filename, std::uint64_t seed, 
+                    std::vector<Location>& lps, std::unique_ptr<LPNameRegistry>& location_names) {
+
+    std::ifstream config_stream;
+    config_stream.open(config_filename);
+    if (!config_stream.is_open()) {
+        return false;
+    }
+
+    std::string buffer;
+    std::string delimiter = ",";
+    size_t pos = 0;
+    std::string token;
+
+    // Diffusion model
+    getline(config_stream, buffer);
+    pos = buffer.find(delimiter);
+    token = buffer.substr(0, pos);
+    unsigned int k = (unsigned int) std::stoul(token);
+    buffer.erase(0, pos + delimiter.length());
+    float beta = std::stof(buffer);
+
+    // Disease model
+    getline(config_stream, buffer);
+    float transmissibility = std::stof(buffer);
+
+    getline(config_stream, buffer);
+    pos = buffer.find(delimiter);
+    token = buffer.substr(0, pos);
+    unsigned int latent_dwell_time = (unsigned int) std::stoul(token);
+    buffer.erase(0, pos + delimiter.length());
+    float latent_infectivity = std::stof(buffer);
+
+    getline(config_stream, buffer);
+    pos = buffer.find(delimiter);
+    token = buffer.substr(0, pos);
+    unsigned int incubating_dwell_time = (unsigned int) std::stoul(token);
+    buffer.erase(0, pos + delimiter.length());
+    float incubating_infectivity = std::stof(buffer);
+
+    getline(config_stream, buffer);
+    pos = buffer.find(delimiter);
+    token = buffer.substr(0, pos);
+    unsigned int infectious_dwell_time = (unsigned int) std::stoul(token);
+    buffer.erase(0, pos + delimiter.length());
+    float infectious_infectivity = std::stof(buffer);
+
+    getline(config_stream, buffer);
+    pos = buffer.find(delimiter);
+    token = buffer.substr(0, pos);
+    unsigned int asympt_dwell_time = (unsigned int) std::stoul(token);
+    buffer.erase(0, pos + delimiter.length());
+    float asympt_infectivity = std::stof(buffer);
+
+    getline(config_stream, buffer);
+    pos = buffer.find(delimiter);
+    token = buffer.substr(0, pos);
+    float prob_ulu = stof(token);
+    buffer.erase(0, pos + delimiter.length());
+    pos = buffer.find(delimiter);
+    token = buffer.substr(0, pos);
+    float prob_ulv = std::stof(token);
+    buffer.erase(0, pos + delimiter.length());
+    pos = buffer.find(delimiter);
+    token = buffer.substr(0, pos);
+    float prob_urv = std::stof(token);
+    buffer.erase(0, pos + delimiter.length());
+    pos = buffer.find(delimiter);
+    token = buffer.substr(0, pos);
+    float prob_uiv = std::stof(token);
+    buffer.erase(0, pos + delimiter.length());
+    float prob_uiu = std::stof(buffer);
+
+    getline(config_stream, buffer);
+    unsigned int location_state_refresh_interval = (unsigned int) stoul(buffer);
+
+    //Population
+    getline(config_stream, buffer);
+    unsigned int num_regions = (unsigned int) std::stoul(buffer);
+
+    std::map<std::string, unsigned int> travel_map;
+
+    for (unsigned int region_id = 0; region_id < num_regions; region_id++) {
+
+        getline(config_stream, buffer);
+        pos = buffer.find(delimiter);
+        std::string region_name = buffer.substr(0, pos);
+        buffer.erase(0, pos + delimiter.length());
+        unsigned int num_locations = (unsigned int) std::stoul(buffer);
+
+        for (unsigned int location_id = 0; location_id < num_locations; location_id++) {
+
+            getline(config_stream, buffer);
+            pos = buffer.find(delimiter);
+            std::string location_name = buffer.substr(0, pos);
+            std::string location = region_name + location_name;
+            buffer.erase(0, pos + delimiter.length());
+            pos = buffer.find(delimiter);
+            token = buffer.substr(0, pos);
+            unsigned int travel_time_to_hub = (unsigned int) std::stoul(token);
+            buffer.erase(0, pos + delimiter.length());
+            pos = buffer.find(delimiter);
+            token = buffer.substr(0, pos);
+            unsigned int diffusion_interval = (unsigned int) std::stoul(token);
+            buffer.erase(0, pos + delimiter.length());
+            unsigned int num_persons = (unsigned int) std::stoul(buffer);
+
+            std::vector<std::shared_ptr<Person>> population;
+            travel_map.insert(std::pair<std::string, unsigned int>(location, travel_time_to_hub));
+
+            for (unsigned int person_id = 0; person_id < num_persons; person_id++) {
+
+                getline(config_stream, buffer);
+                pos = buffer.find(delimiter);
+                token = buffer.substr(0, pos);
+                unsigned long pid = std::stoul(token);
+                buffer.erase(0, pos + delimiter.length());
+                pos = buffer.find(delimiter);
+                token = buffer.substr(0, pos);
+                double susceptibility = std::stod(buffer);
+                buffer.erase(0, pos + delimiter.length());
+                pos = buffer.find(delimiter);
+                token = buffer.substr(0, pos);
+                bool vaccination_status = (bool) std::stoi(token);
+                buffer.erase(0, pos + delimiter.length());
+                infection_state_t state = (infection_state_t) std::stoi(buffer);
+
+                auto person = std::make_shared<Person> (    pid,
+                                                            susceptibility,
+                                                            vaccination_status,
+                                                            state,
+                                                            0,
+                                                            0
+                                                       );
+                population.push_back(person);
+            }
+            lps.emplace_back(   location,
+                                    transmissibility,
+                                    latent_dwell_time,
+                                    incubating_dwell_time,
+                                    infectious_dwell_time,
+                                    asympt_dwell_time,
+                                    latent_infectivity,
+                                    incubating_infectivity,
+                                    infectious_infectivity,
+                                    asympt_infectivity,
+                                    prob_ulu,
+                                    prob_ulv,
+                                    prob_urv,
+                                    prob_uiv,
+                                    prob_uiu,
+                                    location_state_refresh_interval,
+                                    diffusion_interval,
+                                    population,
+                                    travel_time_to_hub, 
+                                    seed, 
+                                    lps.size()
+                                );
+        }
+    }
+    config_stream.close();
+
+    // Create the Watts-Strogatz model
+    auto ws = std::make_shared<WattsStrogatzModel>(k, beta);
+    std::vector<std::string> nodes;
+    for (auto& lp : lps) {
+        nodes.push_back(lp.getLocationName());
+    }
+    ws->populateNodes(nodes);
+    ws->mapNodes();
+
+    location_names.reset(new LPNameRegistry(nodes));
+    std::unordered_map<std::string, unsigned int> location_index;
+    for (unsigned int index = 0; index < location_names->size(); index++) {
+        location_index.emplace((*location_names)[index], index);
+    }
+
+    // Create the travel map
+    for (auto& lp : lps) {
+        std::vector<std::string> connections = ws->fetchNodeLinks(lp.getLocationName());
+        std::map<std::string, unsigned int> temp_travel_map;
+        for (auto& link : connections) {
+            auto travel_map_iter = travel_map.find(link);
+            temp_travel_map.insert(std::pair<std::string, unsigned int>
+                                (travel_map_iter->first, travel_map_iter->second));
+        }
+        std::vector<std::pair<unsigned int, unsigned int>> travel_chart;
+        for (auto& entry : temp_travel_map) {
+            travel_chart.emplace_back(location_index[entry.first], entry.second);
+        }
+        lp.populateTravelDistances(*location_names, travel_chart);
+    }
+
+    return true;
+}
@@ -0,0 +1,103 @@
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include "epidemic.hpp"
+#include "utility/results.hpp"
+#include "tclap/ValueArg.h"
+
+int main(int argc, const char** argv) {
+
+    std::string config_filename = "model_25k.dat";
+    unsigned long seed = 0;
+    std::string results_filename = "";
+    std::string trace_filename = "";
+    TCLAP::ValueArg<std::string> config_arg("m", "model", 
+            "Epidemic model config", false, config_filename, "string");
+    TCLAP::ValueArg<unsigned long> seed_arg("", "seed", 
+            "Global seed of the per-location random streams", false, seed, "unsigned long");
+    TCLAP::ValueArg<std::string> results_arg("", "results", 
+            "Columnar binary file to write each location's final population to", 
+            false, results_filename, "string");
+    TCLAP::ValueArg<std::string> trace_arg("", "trace", 
+            "Binary file to record every processed event to", false, trace_filename, "string");
+    std::vector<TCLAP::Arg*> args = {&config_arg, &seed_arg, &results_arg, &trace_arg};
+
+    warped::Simulation epidemic_sim {"Epidemic Simulation", argc, argv, args};
+
+    config_filename = config_arg.getValue();
+    seed = seed_arg.getValue();
+    results_filename = results_arg.getValue();
+    trace_filename = trace_arg.getValue();
+
+    std::vector<Location> lps;
+    std::unique_ptr<LPNameRegistry> location_names;
+    if (!loadLocations(config_filename, seed, lps, location_names)) {
+        std::cerr << "Invalid configuration file - " << config_filename << std::endl;
+        return 0;
+    }
+
+    TraceWriter trace;
+    if (!trace_filename.empty()) {
+        // The replay reads the same config file, wherever it is run from
+        char* config_path = realpath(config_filename.c_str(), nullptr);
+        std::string absolute_config_filename = config_path ? config_path : config_filename;
+        std::free(config_path);
+
+        if (!trace.open(trace_filename, "epidemic", {
+                {"model", absolute_config_filename},
+                {"seed", std::to_string(seed)}})) {
+            std::cerr << "Could not create trace file - " << trace_filename << std::endl;
+            return 1;
+        }
+        for (auto& lp : lps) {
+            lp.recordTo(&trace);
+        }
+    }
+
+    std::vector<warped::LogicalProcess*> lp_pointers;
+    for (auto& lp : lps) {
+        lp_pointers.push_back(&lp);
+    }
+    auto status = epidemic_sim.simulate(lp_pointers);
+    LocationProfile::report("epidemic", kEpidemicEventNames);
+
+    if (trace.isOpen()) {
+        std::uint64_t dropped = trace.numDropped();
+        if (!trace.close() || dropped) {
+            std::cerr << "Trace file " << trace_filename << " is incomplete, " 
+                                    << dropped << " events not recorded" << std::endl;
+        }
+    }
+
+    if (epidemic_sim.isMasterProcess() && !results_filename.empty()) {
+        std::vector<std::array<std::uint32_t, MAX_INFECTION_STATE_NUM>> counts(lps.size());
+        for (unsigned int i = 0; i < lps.size(); i++) {
+            counts[i].fill(0);
+            for (auto& entry : *lps[i].getLocationState().current_population_) {
+                counts[i][entry.second->infection_state_]++;
+            }
+        }
+        const char* state_names[MAX_INFECTION_STATE_NUM] = {"uninfected", "latent", 
+                                        "incubating", "infectious", "asympt", "recovered"};
+
+        ResultsWriter results {lps.size()};
+        results.addStringColumn("location", 
+                        [&](std::uint64_t i) { return (*location_names)[i]; });
+        results.addColumn<std::uint32_t>("population", [&](std::uint64_t i) { 
+                return (std::uint32_t) lps[i].getLocationState().current_population_->size(); });
+        for (unsigned int state = 0; state < MAX_INFECTION_STATE_NUM; state++) {
+            results.addColumn<std::uint32_t>(state_names[state], 
+                        [&](std::uint64_t i) { return counts[i][state]; });
+        }
+        if (!results.write(results_filename)) {
+            std::cerr << "Could not write results file - " << results_filename << std::endl;
+        }
+    }
+
+    if (epidemic_sim.isMasterProcess()) {
+      std::ofstream ofs { "exit_status", std::ios_base::out | std::ios_base::trunc };
+      ofs << static_cast<int>(status);
+    }
+
+    return static_cast<int>(status);
+}
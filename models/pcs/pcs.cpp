@@ -0,0 +1,270 @@
+// See "Distributed Simulation of Large-Scale PCS Networks" by Carothers et al.
+
+#include <vector>
+#include <memory>
+#include <cassert>
+#include <algorithm>
+#include <random>
+#include <cstdlib>
+
+#include "warped.hpp"
+#include "pcs.hpp"
+#include "utility/memory.hpp"
+
+#define TS_OFFSET 1
+
+WARPED_REGISTER_POLYMORPHIC_SERIALIZABLE_CLASS(PcsState)
+WARPED_REGISTER_POLYMORPHIC_SERIALIZABLE_CLASS(PcsEvent)
+
+std::vector<std::shared_ptr<warped::Event> > PcsCell::initializeLP() {
+
+    // Register random number generator to allow kernel to roll it back
+    this->registerRNG<Philox4x32>(this->rng_);
+
+    std::vector<std::shared_ptr<warped::Event>> events;
+
+    for (unsigned int i = 0; i < portable_init_cnt_; i++) {
+
+        unsigned int complete_call_ts = duration_expo_(*this->rng_) + TS_OFFSET;
+        unsigned int move_call_ts = move_expo_(*this->rng_) + TS_OFFSET;
+        unsigned int next_call_ts = interval_expo_(*this->rng_) + TS_OFFSET;
+
+        auto next_action = min_ts(complete_call_ts, next_call_ts, move_call_ts);
+        switch (next_action) {
+            case COMPLETECALL: {
+                // If channels available, consider it as an ongoing call
+                if (state_.idle_channel_cnt_) {
+                    state_.idle_channel_cnt_--;
+                    events.emplace_back(make_event<PcsEvent>(this->name_, complete_call_ts, 
+                                            complete_call_ts, next_call_ts, 
+                                            move_call_ts, COMPLETE_CALL_METHOD));
+                } else { // Channels not available
+                    complete_call_ts += next_call_ts;
+                    state_.channel_blocks_++;
+                    // If next_call_ts < move_call_ts, start a new call
+                    if (next_call_ts < move_call_ts) {
+                        events.emplace_back(make_event<PcsEvent>(this->name_, next_call_ts, 
+                                            complete_call_ts, next_call_ts, 
+                                            move_call_ts, NEXT_CALL_METHOD));
+                    } else { // Else move to another cell
+                        events.emplace_back(make_event<PcsEvent>(this->name_, move_call_ts, 
+                                            complete_call_ts, next_call_ts, 
+                                            move_call_ts, MOVE_CALL_OUT_METHOD));
+                    }
+                }
+            } break;
+
+            case MOVECALL: {
+                /* Since no channels acquired, complete_call_ts < next_call_ts will 
+                   create an ambiguity in the receiveEvent() */
+                complete_call_ts += next_call_ts;
+                events.emplace_back(make_event<PcsEvent>(this->name_, move_call_ts, 
+                                            complete_call_ts, next_call_ts, 
+                                            move_call_ts, MOVE_CALL_OUT_METHOD));
+            } break;
+
+            case NEXTCALL: {
+                events.emplace_back(make_event<PcsEvent>(this->name_, next_call_ts, 
+                                            complete_call_ts, next_call_ts, 
+                                            move_call_ts, NEXT_CALL_METHOD));
+            } break;
+        }
+    }
+    return events;
+}
+
+std::vector<std::shared_ptr<warped::Event> > PcsCell::receiveEvent(const warped::Event& event) {
+
+    std::vector<std::shared_ptr<warped::Event>> events;
+    const auto& pcs_event = static_cast<const PcsEvent&>(event);
+    if (trace_) {
+        trace_->record(index_, pcs_event.method_, pcs_event);
+    }
+    auto profile = PcsCellProfile::start(pcs_event.method_);
+
+    unsigned int complete_call_ts = 0, move_call_ts = 0, next_call_ts = 0;
+    action_t next_action;
+
+    switch (pcs_event.method_) {
+
+        case NEXT_CALL_METHOD: {
+
+            move_call_ts = pcs_event.move_call_ts_;
+            complete_call_ts = pcs_event.complete_call_ts_;
+            next_call_ts = pcs_event.next_call_ts_;
+            assert(next_call_ts < complete_call_ts);
+            state_.call_attempts_++;
+
+            if (!state_.idle_channel_cnt_) { // Channels not available
+                state_.channel_blocks_++;
+                next_call_ts += interval_expo_(*this->rng_) + TS_OFFSET;
+                complete_call_ts = next_call_ts + duration_expo_(*this->rng_) + TS_OFFSET;
+                if (next_call_ts < move_call_ts) {
+                    events.emplace_back(make_event<PcsEvent>(this->name_, next_call_ts, 
+                                        complete_call_ts, next_call_ts, 
+                                        move_call_ts, NEXT_CALL_METHOD));
+                } else {
+                    events.emplace_back(make_event<PcsEvent>(this->name_, move_call_ts, 
+                                        complete_call_ts, next_call_ts, 
+                                        move_call_ts, MOVE_CALL_OUT_METHOD));
+                }
+            } else { // Channels available
+                state_.idle_channel_cnt_--;
+                next_call_ts = complete_call_ts + interval_expo_(*this->rng_) + TS_OFFSET;
+                if (complete_call_ts < move_call_ts) {
+                    events.emplace_back(make_event<PcsEvent>(this->name_, complete_call_ts, 
+                                        complete_call_ts, next_call_ts, 
+                                        move_call_ts, COMPLETE_CALL_METHOD));
+                } else {
+                    events.emplace_back(make_event<PcsEvent>(this->name_, move_call_ts, 
+                                        complete_call_ts, next_call_ts, 
+                                        move_call_ts, MOVE_CALL_OUT_METHOD));
+                }
+            }
+        } break;
+
+        case COMPLETE_CALL_METHOD: {
+
+            state_.idle_channel_cnt_++;
+            next_call_ts = pcs_event.next_call_ts_;
+            move_call_ts = pcs_event.move_call_ts_;
+            assert(complete_call_ts <= next_call_ts);
+            complete_call_ts = next_call_ts + duration_expo_(*this->rng_) + TS_OFFSET;
+
+            next_action = min_ts(complete_call_ts, next_call_ts, move_call_ts);
+            switch (next_action) {
+                case MOVECALL: {
+                    events.emplace_back(make_event<PcsEvent>(this->name_, move_call_ts, 
+                                        complete_call_ts, next_call_ts, 
+                                        move_call_ts, MOVE_CALL_OUT_METHOD));
+                } break;
+
+                case COMPLETECALL: {
+                    assert(0);
+                } break;
+
+                case NEXTCALL: {
+                    events.emplace_back(make_event<PcsEvent>(this->name_, next_call_ts, 
+                                        complete_call_ts, next_call_ts, 
+                                        move_call_ts, NEXT_CALL_METHOD));
+                } break;
+            }
+        } break;
+
+        case MOVE_CALL_OUT_METHOD: {
+
+            complete_call_ts = pcs_event.complete_call_ts_ + TS_OFFSET;
+            next_call_ts = pcs_event.next_call_ts_ + TS_OFFSET;
+            move_call_ts = pcs_event.move_call_ts_ + TS_OFFSET;
+            assert(MOVECALL == min_ts(complete_call_ts, next_call_ts, move_call_ts));
+
+            if (complete_call_ts <= next_call_ts) {
+                state_.idle_channel_cnt_++;
+            }
+            events.emplace_back(make_event<PcsEvent>(random_move(), move_call_ts, 
+                                        complete_call_ts, next_call_ts, 
+                                        move_call_ts, MOVE_CALL_IN_METHOD));
+        } break;
+
+        case MOVE_CALL_IN_METHOD: {
+
+            complete_call_ts = pcs_event.complete_call_ts_;
+            next_call_ts = pcs_event.next_call_ts_;
+            move_call_ts = pcs_event.move_call_ts_ + move_expo_(*this->rng_) + TS_OFFSET;
+            next_action = min_ts(complete_call_ts, next_call_ts, move_call_ts);
+
+            // Call handover only if complete_call_ts <= next_call_ts
+            if (complete_call_ts <= next_call_ts) {
+
+                // No channels available
+                if (!state_.idle_channel_cnt_) {
+                    state_.handoff_blocks_++;
+                    state_.channel_blocks_++;
+
+                    complete_call_ts = next_call_ts + duration_expo_(*this->rng_) + TS_OFFSET;
+
+                    // End call and schedule a new one if next_call_ts < move_call_ts
+                    if (next_call_ts < move_call_ts) {
+                        events.emplace_back(make_event<PcsEvent>(this->name_, next_call_ts, 
+                                                        complete_call_ts, next_call_ts, 
+                                                        move_call_ts, NEXT_CALL_METHOD));
+                    } else {
+                        events.emplace_back(make_event<PcsEvent>(this->name_, move_call_ts, 
+                                                        complete_call_ts, next_call_ts, 
+                                                        move_call_ts, MOVE_CALL_OUT_METHOD));
+                    }
+                } else { // Channels available, complete call
+                    state_.idle_channel_cnt_--;
+
+                    switch (next_action) {
+                        case NEXTCALL: {
+                            assert(0);
+                        } break;
+
+                        case COMPLETECALL: {
+                            events.emplace_back(make_event<PcsEvent>(this->name_, complete_call_ts, 
+                                                        complete_call_ts, next_call_ts, 
+                                                        move_call_ts, COMPLETE_CALL_METHOD));
+                        } break;
+
+                        case MOVECALL: {
+                            events.emplace_back(make_event<PcsEvent>(this->name_, move_call_ts, 
+                                                        complete_call_ts, next_call_ts, 
+                                                        move_call_ts, MOVE_CALL_OUT_METHOD));
+                        } break;
+                    }
+                }
+            } else { // Portable was not busy
+                switch (next_action) {
+                    case COMPLETECALL: {
+                        assert(0);
+                    } break;
+
+                    case NEXTCALL: {
+                        events.emplace_back(make_event<PcsEvent>(this->name_, next_call_ts, 
+                                                        complete_call_ts, next_call_ts, 
+                                                        move_call_ts, NEXT_CALL_METHOD));
+                    } break;
+
+                    case MOVECALL: {
+                        events.emplace_back(make_event<PcsEvent>(this->name_, move_call_ts, 
+                                                        complete_call_ts, next_call_ts, 
+                                                        move_call_ts, MOVE_CALL_OUT_METHOD));
+                    } break;
+                }
+            }
+        } break;
+
+        default: {
+            assert(0);
+        }
+    }
+    PcsCellProfile::stop(profile, events.size());
+    return events;
+}
+
+const std::string& PcsCell::compute_move(direction_t direction) {
+
+    return lp_names_[grid_.neighbour(index_, direction)];
+}
+
+const std::string& PcsCell::random_move() {
+
+    return this->compute_move((direction_t)rand_direction_(*this->rng_));
+}
+
+action_t PcsCell::min_ts(   unsigned int complete_call_ts, 
+                            unsigned int next_call_ts, 
+                            unsigned int move_call_ts) {
+
+    action_t next_action;
+    // If next call ts is greater than complete call ts
+    if (complete_call_ts <= next_call_ts) {
+        // If complete call == move call, move call takes preceedence
+        next_action = (complete_call_ts < move_call_ts) ? COMPLETECALL : MOVECALL;
+    } else {
+        // If next call == move call, move call takes preceedence
+        next_action = (next_call_ts < move_call_ts) ? NEXTCALL : MOVECALL;
+    }
+    return next_action;
+}
@@ -7,21 +7,33 @@
 #include <random>
 
 #include "warped.hpp"
+#include "utility/event_profile.hpp"
+#include "utility/grid_topology.hpp"
+#include "utility/lp_names.hpp"
+#include "utility/philox.hpp"
+#include "utility/pod_state.hpp"
+#include "utility/samplers.hpp"
+#include "utility/trace.hpp"
 
-WARPED_DEFINE_LP_STATE_STRUCT(PcsState) {
+struct PcsCounters {
 
     unsigned int idle_channel_cnt_;
     unsigned int call_attempts_;
     unsigned int channel_blocks_;
     unsigned int handoff_blocks_;
+};
+
+WARPED_MODELS_ASSERT_POD_STATE(PcsCounters);
+
+WARPED_DEFINE_LP_STATE_STRUCT(PcsState), public PcsCounters {
 
     template <typename Archive>
     void save(Archive& ar) const {
-      ar(idle_channel_cnt_, call_attempts_, channel_blocks_, handoff_blocks_);
+      savePodState<PcsCounters>(ar, *this);
     }
     template <typename Archive>
     void load(Archive& ar) {
-      ar(idle_channel_cnt_, call_attempts_, channel_blocks_, handoff_blocks_);
+      loadPodState<PcsCounters>(ar, *this);
     }
 };
 
@@ -42,10 +54,10 @@ enum action_t {
 
 enum direction_t {
 
-    LEFT,
-    RIGHT,
-    DOWN,
-    UP
+    LEFT    = SquareGrid2D::LEFT,
+    RIGHT   = SquareGrid2D::RIGHT,
+    DOWN    = SquareGrid2D::DOWN,
+    UP      = SquareGrid2D::UP
 };
 
 class PcsEvent : public warped::Event {
@@ -53,7 +65,7 @@ public:
 
     PcsEvent() = default;
 
-    PcsEvent(   const std::string   receiver_name, 
+    PcsEvent(   const std::string&  receiver_name, 
                 unsigned int        event_ts, 
                 unsigned int        complete_call_ts, 
                 unsigned int        next_call_ts, 
@@ -86,27 +98,28 @@ public:
 class PcsCell : public warped::LogicalProcess {
 public:
 
-    PcsCell(    const std::string&  name, 
-                unsigned int        num_cells_x, 
-                unsigned int        num_cells_y, 
+    PcsCell(    const LPNameRegistry& lp_names, 
+                const Torus2D&      grid, 
                 unsigned int        max_channel_cnt, 
                 unsigned int        call_interval_mean, 
                 unsigned int        call_duration_mean, 
                 unsigned int        move_interval_mean, 
                 unsigned int        portable_cnt, 
+                std::uint64_t       seed, 
                 unsigned int        index      )
 
-        :   LogicalProcess(name), 
+        :   LogicalProcess(lp_names[index]), 
             state_(), 
-            num_cells_x_(num_cells_x), 
-            num_cells_y_(num_cells_y), 
+            lp_names_(lp_names), 
+            grid_(grid), 
             max_channel_cnt_(max_channel_cnt), 
-            call_interval_mean_(call_interval_mean), 
-            call_duration_mean_(call_duration_mean), 
-            move_interval_mean_(move_interval_mean),
             portable_init_cnt_(portable_cnt),
             index_(index),
-            rng_(new std::default_random_engine(index)) {
+            rng_(new Philox4x32(seed, index)),
+            interval_expo_(call_interval_mean),
+            duration_expo_(call_duration_mean),
+            move_expo_(move_interval_mean),
+            rand_direction_(0, Torus2D::kDegree-1) {
 
         // Update the state variables
         state_.idle_channel_cnt_ = max_channel_cnt_;
@@ -121,27 +134,36 @@ public:
 
     virtual std::vector<std::shared_ptr<warped::Event> > receiveEvent(const warped::Event&);
 
+    // Records every processed event to 'trace' from now on
+    void recordTo(TraceWriter* trace) { trace_ = trace; }
+
     PcsState state_;
 
 protected:
 
-    unsigned int num_cells_x_;
-    unsigned int num_cells_y_;
+    const LPNameRegistry& lp_names_;
+    const Torus2D& grid_;
     unsigned int max_channel_cnt_;
-    unsigned int call_interval_mean_;
-    unsigned int call_duration_mean_;
-    unsigned int move_interval_mean_;
     unsigned int portable_init_cnt_;
     unsigned int index_;
 
-    std::shared_ptr<std::default_random_engine> rng_;
+    std::shared_ptr<Philox4x32> rng_;
+    const PoissonSampler interval_expo_;
+    const PoissonSampler duration_expo_;
+    const PoissonSampler move_expo_;
+    const UniformIntSampler rand_direction_;
+    TraceWriter* trace_ = nullptr;
 
-    std::string compute_move(direction_t direction);
-    std::string random_move();
+    const std::string& compute_move(direction_t direction);
+    const std::string& random_move();
 
     action_t min_ts(unsigned int complete_call_ts, 
                     unsigned int next_call_ts, 
                     unsigned int move_call_ts);
 };
 
+typedef EventProfile<PcsCell, 4> PcsCellProfile;
+const char* const kPcsMethodNames[] = {"NEXT_CALL", "COMPLETE_CALL", "MOVE_CALL_IN", 
+                                                                        "MOVE_CALL_OUT"};
+
 #endif
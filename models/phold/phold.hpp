@@ -0,0 +1,490 @@
+// An implementation of the synthetic PHOLD simulation model
+// See "Performance of Time Warp Under Synthetic Workloads" by R.M. Fujimoto
+
+#ifndef PHOLD_HPP_DEFINED
+#define PHOLD_HPP_DEFINED
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "warped.hpp"
+#include "cereal/types/vector.hpp"
+#include "utility/event_profile.hpp"
+#include "utility/flop_work.hpp"
+#include "utility/lp_names.hpp"
+#include "utility/memory.hpp"
+#include "utility/philox.hpp"
+#include "utility/pod_state.hpp"
+#include "utility/samplers.hpp"
+#include "utility/trace.hpp"
+
+enum distribution_t {UNIFORM, POISSON, EXPONENTIAL, NORMAL, BINOMIAL, FIXED,
+                     ALTERNATE, ROUNDROBIN, CONDITIONAL, ALL};
+
+// Indexed by distribution_t
+const char* const kDistributionNames[] = {"UNIFORM", "POISSON", "EXPONENTIAL", "NORMAL",
+                    "BINOMIAL", "FIXED", "ALTERNATE", "ROUNDROBIN", "CONDITIONAL", "ALL"};
+
+// The distributions that ALL deals out to the LPs in turn. BINOMIAL is left
+// out since its delays are always 0.
+const distribution_t kAllDistributions[] = {UNIFORM, POISSON, EXPONENTIAL, NORMAL, FIXED};
+
+struct PholdCounters {
+    unsigned int messages_sent_;
+    unsigned int messages_received_;
+    // Of the delays of the events sent, the lookahead achieved
+    unsigned int min_delay_;
+    std::uint64_t total_delay_;
+};
+
+WARPED_MODELS_ASSERT_POD_STATE(PholdCounters);
+
+// The settings that phases of a run can change: delays, and how many events
+// leave the neighbourhood and for where
+struct PholdRegime {
+    PholdRegime(distribution_t distribution, double mean, double self_fraction, 
+                            double local_fraction, std::uint32_t hot_set_offset = 0)
+        : distribution_(distribution), mean_(mean),
+            self_below_((std::uint64_t) (self_fraction * 4294967296.0)),
+            local_below_((std::uint64_t) ((self_fraction + local_fraction) * 4294967296.0)),
+            hot_set_offset_(hot_set_offset),
+            uniform_(0, (std::int64_t) (2*mean)), expo_(mean), normal_(mean, 1.0),
+            poisson_((distribution == POISSON) || (distribution == ALL) ? (int) mean : 0) {}
+
+    distribution_t distribution_;
+    double mean_;
+    // A raw draw below self_below_ picks the LP itself, below local_below_ a
+    // neighbour
+    std::uint64_t self_below_;
+    std::uint64_t local_below_;
+    // Added to Zipf ranks, so that the hot set starts at this LP
+    std::uint32_t hot_set_offset_;
+
+    // Only the Poisson table depends on the mean, so it is built only when used
+    UniformIntSampler uniform_;
+    ExponentialSampler expo_;
+    NormalSampler normal_;
+    PoissonSampler poisson_;
+};
+
+struct PholdPhase {
+    unsigned int start_;
+    PholdRegime regime_;
+};
+
+// Run-wide PHOLD settings, from which a PholdRun is built
+struct PholdConfig {
+    // Each event goes to the sending LP itself with probability self_fraction_,
+    // to one of the 2k LPs within k = neighbourhood_ indices of it (wrapping
+    // around) with probability local_fraction_, and otherwise to an LP drawn
+    // from all of them, uniformly or by Zipf's law
+    double self_fraction_ = 0.0;
+    double local_fraction_ = 0.0;
+    unsigned int neighbourhood_ = 1;
+
+    // Zipf ranks map to LPs in index order, LP 0 the hottest, so the hot set
+    // is a contiguous block of LPs. Every hot_set_period_ units of simulation
+    // time (never if 0) the block moves on by hot_set_shift_ LPs.
+    bool zipf_destinations_ = false;
+    double zipf_exponent_ = 1.0;
+    unsigned int hot_set_period_ = 0;
+    unsigned int hot_set_shift_ = 0;
+
+    // Floating-point operations each event costs, on average over the LPs.
+    // With a UNIFORM or EXPONENTIAL grain distribution every LP scales it by
+    // its own draw from that distribution with mean 1; with FIXED all LPs
+    // do the same work.
+    std::uint64_t event_grain_flops_ = 0;
+    distribution_t grain_distribution_ = FIXED;
+
+    // Size of the payload every LP state carries, and the share of it each
+    // event rewrites
+    std::uint32_t state_bytes_ = 0;
+    double state_modified_fraction_ = 1.0;
+
+    // Size of the payload every event carries
+    std::uint32_t payload_bytes_ = 0;
+
+    // Added to every delay, so that no event is sent less than this far ahead
+    unsigned int lookahead_ = 0;
+
+    // With probability fanout_probability_ an event sends fanout_ events in
+    // response instead of one; 0 makes it the last of its line.
+    unsigned int fanout_ = 2;
+    double fanout_probability_ = 0.0;
+
+    // Unless 0, the number of pending events to hold the population near.
+    // Every LP is given its share of it and caps its sent minus received
+    // count at that share: an LP at or over its share absorbs the events it
+    // receives, and one under it sends at least one event and at most its
+    // shortfall. Only fan-out makes the population grow.
+    std::uint64_t population_target_ = 0;
+
+    // Phases of the run, in order of start time. Before the first one starts,
+    // LPs use the settings they were built with.
+    std::vector<PholdPhase> phases_;
+
+    static const PholdConfig& defaults() {
+        static const PholdConfig config;
+        return config;
+    }
+};
+
+// The payload is copied with the counters whenever the kernel saves the state
+WARPED_DEFINE_LP_STATE_STRUCT(PholdState), public PholdCounters {
+
+    std::vector<unsigned char> payload_;
+
+    template <typename Archive>
+    void save(Archive& ar) const {
+        savePodState<PholdCounters>(ar, *this);
+        ar(payload_);
+    }
+    template <typename Archive>
+    void load(Archive& ar) {
+        loadPodState<PholdCounters>(ar, *this);
+        ar(payload_);
+    }
+};
+
+class PholdEvent : public warped::Event {
+public:
+    PholdEvent() = default;
+    PholdEvent(const std::string& receiver_name, const unsigned int timestamp,
+                                                        std::uint32_t payload_bytes = 0)
+                    : receiver_name_(receiver_name), time_stamp_(timestamp), 
+                        payload_(payload_bytes, (unsigned char) timestamp) {}
+
+    const std::string& receiverName() const { return receiver_name_; }
+    unsigned int timestamp() const { return time_stamp_; }
+
+    std::string receiver_name_;
+    unsigned int time_stamp_;
+    // Opaque bytes that only add to the size of the message
+    std::vector<unsigned char> payload_;
+
+    WARPED_REGISTER_SERIALIZABLE_MEMBERS(cereal::base_class<warped::Event>(this), 
+                                                        receiver_name_, time_stamp_, payload_)
+};
+
+// Everything the LPs of a run share, built once and referred to by every LP,
+// so that an LP itself holds only its index, its engine and its state
+class PholdRun {
+public:
+    PholdRun(const LPNameRegistry& lp_names, unsigned int initial_events, std::uint64_t seed,
+                distribution_t distribution, double distribution_mean = 1.0,
+                const PholdConfig& config = PholdConfig::defaults())
+        : lp_names_(lp_names), num_lps_(lp_names.size()), initial_events_(initial_events),
+            seed_(seed), config_(config), hot_set_shift_(config.hot_set_shift_ % num_lps_),
+            state_modified_bytes_((std::uint32_t) std::ceil(config.state_modified_fraction_ 
+                                                            * config.state_bytes_)),
+            fanout_below_((std::uint64_t) (config.fanout_probability_ * 4294967296.0)),
+            dest_(0, num_lps_-1), neighbour_(0, 2*(std::int64_t) config.neighbourhood_ - 1),
+            zipf_(config.zipf_destinations_ ? num_lps_ : 1, config.zipf_exponent_) {
+        // ALL deals its distributions out to the LPs in turn
+        if (distribution == ALL) {
+            for (auto share : kAllDistributions) {
+                regimes_.emplace_back(share, distribution_mean, config.self_fraction_, 
+                                                                config.local_fraction_);
+            }
+        } else {
+            regimes_.emplace_back(distribution, distribution_mean, config.self_fraction_,
+                                                                config.local_fraction_);
+        }
+    }
+
+    // The settings of LP 'index' before the first phase. Its distribution is
+    // never ALL but the LP's own share of the distributions.
+    const PholdRegime& initialRegime(unsigned int index) const {
+        return regimes_[index % regimes_.size()];
+    }
+
+    // LP 'index''s share of the population target
+    std::int64_t populationShare(unsigned int index) const {
+        return (std::int64_t) (config_.population_target_ / num_lps_ + 
+                                    (index < config_.population_target_ % num_lps_));
+    }
+
+    // Records every event processed by the LPs to 'trace' from now on
+    void recordTo(TraceWriter* trace) { trace_ = trace; }
+
+    const LPNameRegistry& lp_names_;
+    const unsigned int num_lps_;
+    const unsigned int initial_events_;
+    const std::uint64_t seed_;
+    const PholdConfig config_;
+
+    const unsigned int hot_set_shift_;
+    const std::uint32_t state_modified_bytes_;
+    // A raw draw below fanout_below_ fans out
+    const std::uint64_t fanout_below_;
+
+    // The Zipf table is built only when used
+    const UniformIntSampler dest_;
+    const UniformIntSampler neighbour_;
+    const ZipfSampler zipf_;
+
+    TraceWriter* trace_ = nullptr;
+
+private:
+    std::vector<PholdRegime> regimes_;
+};
+
+class PholdLP : public warped::LogicalProcess {
+public:
+    PholdLP(const PholdRun& run, unsigned int index)
+        : LogicalProcess(run.lp_names_[index]), state_(), run_(run), index_(index),
+            rng_(run.seed_, index), grain_flops_(lp_grain(run.config_, run.seed_, index)) {
+        state_.min_delay_ = std::numeric_limits<unsigned int>::max();
+        state_.payload_.assign(run.config_.state_bytes_, 0);
+    }
+
+    warped::LPState& getState() { return this->state_; }
+
+    std::vector<std::shared_ptr<warped::Event> > initializeLP() override {
+
+        // The engine lives in the LP, which outlives the kernel's use of it, so
+        // the kernel is handed a pointer that owns nothing
+        this->registerRNG(std::shared_ptr<Philox4x32>(std::shared_ptr<Philox4x32>(), &rng_));
+
+        std::vector<std::shared_ptr<warped::Event> > events;
+        for (unsigned int i = 0; i < run_.initial_events_; i++) {
+            ++this->state_.messages_sent_;
+            const std::string& destination = this->get_destination(0);
+            events.emplace_back(make_event<PholdEvent>(destination, this->next_delay(0),
+                                                            run_.config_.payload_bytes_));
+        }
+        return events;
+    }
+
+    std::vector<std::shared_ptr<warped::Event>> receiveEvent(const warped::Event& event) {
+        if (run_.trace_) {
+            run_.trace_->record(index_, 0, static_cast<const PholdEvent&>(event));
+        }
+        auto profile = EventProfile<PholdLP, 1>::start(0);
+        ++this->state_.messages_received_;
+        if (grain_flops_) {
+            doFlops(grain_flops_);
+        }
+        if (run_.state_modified_bytes_) {
+            modify_state();
+        }
+        std::vector<std::shared_ptr<warped::Event> > response_events;
+        unsigned int now = event.timestamp();
+        for (unsigned int i = 0, n = this->num_responses(); i < n; i++) {
+            // Counted first, as in initializeLP(), for the modes that depend on it
+            ++this->state_.messages_sent_;
+            const std::string& destination = this->get_destination(now);
+            response_events.emplace_back(make_event<PholdEvent>(destination,
+                                    now + this->next_delay(now), run_.config_.payload_bytes_));
+        }
+        EventProfile<PholdLP, 1>::stop(profile, response_events.size());
+        return response_events;
+    }
+
+    PholdState state_;
+
+protected:
+    const PholdRun& run_;
+    const unsigned int index_;
+    mutable Philox4x32 rng_;
+    const std::uint64_t grain_flops_;
+
+    static std::uint64_t lp_grain(const PholdConfig& config, std::uint64_t seed, 
+                                                                unsigned int index) {
+        if (config.grain_distribution_ == FIXED) {
+            return config.event_grain_flops_;
+        }
+        // Drawn from a stream of its own, so that the event stream is unchanged
+        Philox4x32 rng(seed, (std::uint64_t(1) << 32) | index);
+        double scale = (config.grain_distribution_ == UNIFORM) ? 
+                        UniformRealSampler(0.0, 2.0)(rng) : ExponentialSampler(1.0)(rng);
+        return (std::uint64_t) (scale * config.event_grain_flops_ + 0.5);
+    }
+
+    // Rewrites state_modified_bytes_ of the payload, as a window that moves on
+    // by its own length with every event
+    void modify_state() {
+        std::vector<unsigned char>& payload = this->state_.payload_;
+        std::uint32_t modified = run_.state_modified_bytes_;
+        std::size_t size = payload.size();
+        std::size_t start = (std::size_t) this->state_.messages_received_ * modified % size;
+        std::size_t first = std::min<std::size_t>(modified, size - start);
+        unsigned char value = (unsigned char) this->state_.messages_received_;
+        std::fill_n(payload.begin() + start, first, value);
+        std::fill_n(payload.begin(), modified - first, value);
+    }
+
+    // The settings in force at simulation time 'now'
+    const PholdRegime& get_regime(unsigned int now) const {
+        const std::vector<PholdPhase>& phases = run_.config_.phases_;
+        if (phases.empty() || (now < phases.front().start_)) {
+            return run_.initialRegime(index_);
+        }
+        auto next = std::upper_bound(phases.begin(), phases.end(), now, 
+                    [](unsigned int time, const PholdPhase& phase) { return time < phase.start_; });
+        return std::prev(next)->regime_;
+    }
+
+    // The LP's share of ALL
+    distribution_t get_distribution(const PholdRegime& regime) const {
+        return (regime.distribution_ == ALL) ? kAllDistributions[index_ % 5] 
+                                             : regime.distribution_;
+    }
+
+    // Any LP, as sent at simulation time 'now'
+    unsigned int get_remote_destination(const PholdRegime& regime, unsigned int now) const {
+        if (!run_.config_.zipf_destinations_) {
+            return (unsigned int) run_.dest_(rng_);
+        }
+        std::uint64_t rank = (std::uint64_t) run_.zipf_(rng_) + regime.hot_set_offset_;
+        unsigned int period = run_.config_.hot_set_period_;
+        if (period) {
+            rank += (std::uint64_t) (now / period) % run_.num_lps_ * run_.hot_set_shift_;
+        }
+        return (unsigned int) (rank % run_.num_lps_);
+    }
+
+    const std::string& get_destination(unsigned int now) const {
+        const PholdRegime& regime = get_regime(now);
+        const unsigned int num_lps = run_.num_lps_;
+        // LP i sends its k-th event, counting from 1, to LP i+k, wrapping around
+        if (regime.distribution_ == ROUNDROBIN) {
+            std::uint64_t k = this->state_.messages_sent_;
+            return run_.lp_names_[(unsigned int) ((index_ + k) % num_lps)];
+        }
+        // Without locality the stream of draws is the same as before it existed
+        if (regime.local_below_ == 0) {
+            return run_.lp_names_[get_remote_destination(regime, now)];
+        }
+        std::uint32_t u = rng_();
+        if (u < regime.self_below_) {
+            return run_.lp_names_[index_];
+        }
+        if (u < regime.local_below_) {
+            // Offsets -k..-1 and 1..k
+            unsigned int k = run_.config_.neighbourhood_;
+            unsigned int d = (unsigned int) run_.neighbour_(rng_);
+            std::uint64_t offset = (d < k) ? num_lps - (d + 1) % num_lps 
+                                           : (d - k + 1) % num_lps;
+            return run_.lp_names_[(unsigned int) ((index_ + offset) % num_lps)];
+        }
+        return run_.lp_names_[get_remote_destination(regime, now)];
+    }
+
+    // How many events to send in response to the one just received
+    unsigned int num_responses() const {
+        unsigned int n = 1;
+        // Without fan-out the stream of draws is the same as before it existed
+        if (run_.fanout_below_ && (rng_() < run_.fanout_below_)) {
+            n = run_.config_.fanout_;
+        }
+        if (run_.config_.population_target_) {
+            std::int64_t pending = (std::int64_t) this->state_.messages_sent_ 
+                                    - (std::int64_t) this->state_.messages_received_;
+            std::int64_t shortfall = run_.populationShare(index_) - pending;
+            n = (shortfall <= 0) ? 0 : (unsigned int) std::max<std::int64_t>(1, 
+                                                    std::min<std::int64_t>(n, shortfall));
+        }
+        return n;
+    }
+
+    // The delay of the next event sent, lookahead included, counted in the
+    // state's delay statistics
+    unsigned int next_delay(unsigned int now) {
+        unsigned int delay = run_.config_.lookahead_ + get_timestamp_delay(now);
+        this->state_.min_delay_ = std::min(this->state_.min_delay_, delay);
+        this->state_.total_delay_ += delay;
+        return delay;
+    }
+
+    // Delays for events sent at simulation time 'now'. Besides the plain
+    // distributions,
+    //
+    //   ALTERNATE    every other event has an exponential delay of 1/10 of
+    //                the mean, and the rest of 19/10, so that short and long
+    //                delays are interleaved
+    //   ROUNDROBIN   exponential delays
+    //   CONDITIONAL  an LP that has received more events than its share so
+    //                far, initial_events / mean per unit of time, is busy and
+    //                sends with exponential delays of twice the mean; an LP
+    //                that is not sends with uniform ones
+    unsigned int get_timestamp_delay(unsigned int now) const {
+        const PholdRegime& regime = get_regime(now);
+        double delay;
+        switch ( get_distribution(regime) ) {
+            case UNIFORM : {
+                delay = regime.uniform_(rng_);
+            } break;
+
+            case NORMAL : {
+                delay = (unsigned int) regime.normal_(rng_);
+            } break;
+
+            case BINOMIAL : {
+                std::binomial_distribution<int> binomial((int)regime.mean_, 0.0);
+                delay = binomial(rng_);
+            } break;
+
+            case POISSON : {
+                delay = regime.poisson_(rng_);
+            } break;
+
+            case EXPONENTIAL : {
+                delay = (unsigned int) regime.expo_(rng_);
+            } break;
+
+            case FIXED : {
+                delay = (unsigned int) regime.mean_ ;
+            } break;
+
+            case ALTERNATE : {
+                double scale = (this->state_.messages_sent_ % 2) ? 1.9 : 0.1;
+                delay = (unsigned int) (scale * regime.expo_(rng_));
+            } break;
+
+            case ROUNDROBIN : {
+                delay = (unsigned int) regime.expo_(rng_);
+            } break;
+
+            case CONDITIONAL : {
+                bool busy = this->state_.messages_received_ * regime.mean_ > 
+                                            (double) run_.initial_events_ * now;
+                delay = busy ? (unsigned int) (2.0 * regime.expo_(rng_)) 
+                             : regime.uniform_(rng_);
+            } break;
+
+            default : {
+                delay = 0;
+                std::cerr << "Improper Distribution for a Source LP!!!" << std::endl;
+            }
+        }
+        return ( (unsigned int) delay );
+    }
+};
+
+typedef EventProfile<PholdLP, 1> PholdProfile;
+const char* const kPholdEventNames[] = {"PholdEvent"};
+
+// Appends the phases of a schedule to 'phases'. A schedule is a list of
+// phases separated by semicolons, each a start time followed by the settings
+// it changes,
+//
+//   1000 distribution=UNIFORM mean=5; 2000 remote=0.1 hot-set=5000
+//
+// where remote is the fraction of events that leave the neighbourhood and
+// hot-set the LP that the Zipf hot set starts at. Every phase keeps the
+// settings of the one before it, and the first those of the command line,
+// given as 'distribution', 'mean' and 'config'. Returns false, with a
+// message in 'error', if the schedule is invalid.
+bool parsePholdPhases(const std::string& schedule, distribution_t distribution, double mean,
+                        const PholdConfig& config, std::vector<PholdPhase>& phases,
+                        std::string& error);
+
+#endif
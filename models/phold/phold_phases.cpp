@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <strings.h>
+
+#include "phold.hpp"
+
+bool parsePholdPhases(const std::string& schedule, distribution_t distribution, double mean,
+                        const PholdConfig& config, std::vector<PholdPhase>& phases,
+                        std::string& error) {
+
+    // Settings carried from one phase to the next
+    unsigned int previous_start = 0;
+    double remote_fraction = 1.0 - config.self_fraction_ - config.local_fraction_;
+    std::uint32_t hot_set_offset = 0;
+
+    std::istringstream phase_stream(schedule);
+    std::string phase_text;
+    while (std::getline(phase_stream, phase_text, ';')) {
+        std::istringstream tokens(phase_text);
+        std::string token;
+        if (!(tokens >> token)) {
+            continue;
+        }
+
+        unsigned int start = 0;
+        std::size_t digits = 0;
+        try {
+            start = (unsigned int) std::stoul(token, &digits);
+        } catch (const std::exception&) {}
+        if (!digits || (digits != token.size())) {
+            error = "phase start time expected, not " + token;
+            return false;
+        }
+        if (!phases.empty() && (start <= previous_start)) {
+            error = "phase at " + token + " does not start after the one before it";
+            return false;
+        }
+        previous_start = start;
+
+        while (tokens >> token) {
+            std::string::size_type equals = token.find('=');
+            std::string key = token.substr(0, equals);
+            std::string value = (equals == std::string::npos) ? "" : token.substr(equals + 1);
+            try {
+                if (key == "distribution") {
+                    unsigned int d = 0;
+                    while ((d <= ALL) && strcasecmp(kDistributionNames[d], value.c_str())) d++;
+                    if (d > ALL) {
+                        error = "unknown distribution " + value;
+                        return false;
+                    }
+                    distribution = (distribution_t) d;
+                } else if (key == "mean") {
+                    mean = std::stod(value);
+                } else if (key == "remote") {
+                    remote_fraction = std::stod(value);
+                } else if (key == "hot-set") {
+                    hot_set_offset = (std::uint32_t) std::stoul(value);
+                } else {
+                    error = "unknown phase setting " + token;
+                    return false;
+                }
+            } catch (const std::exception&) {
+                error = "invalid value in " + token;
+                return false;
+            }
+        }
+
+        // The self fraction stays, and the neighbourhood takes what is left
+        double local_fraction = 1.0 - config.self_fraction_ - remote_fraction;
+        if (!(remote_fraction >= 0.0) || (local_fraction < -1e-9)) {
+            error = "remote fraction of the phase at " + std::to_string(start) +
+                        " must be between 0 and 1 - self-fraction";
+            return false;
+        }
+        phases.push_back(PholdPhase {start, PholdRegime(distribution, mean,
+                            config.self_fraction_, std::max(local_fraction, 0.0), hot_set_offset)});
+    }
+    return true;
+}
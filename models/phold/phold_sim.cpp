@@ -3,133 +3,20 @@
 
 #include <string>
 #include <vector>
-#include <memory>
 #include <iostream>
 #include <algorithm>
 #include <cstdlib>
-#include <memory>
+#include <sstream>
+#include <limits>
+#include <fstream>
 
-#include "warped.hpp"
+#include "phold.hpp"
+#include "utility/lp_array.hpp"
+#include "utility/results.hpp"
 #include "tclap/ValueArg.h"
 
-std::random_device rd;
-
-enum distribution_t {UNIFORM, POISSON, EXPONENTIAL, NORMAL, BINOMIAL, FIXED,
-                     ALTERNATE, ROUNDROBIN, CONDITIONAL, ALL};
-
-WARPED_DEFINE_LP_STATE_STRUCT(PholdState) {
-    unsigned int messages_sent_;
-    unsigned int messages_received_;
-};
-
-class PholdEvent : public warped::Event {
-public:
-    PholdEvent() = default;
-    PholdEvent(const std::string& receiver_name, const unsigned int timestamp)
-                    : receiver_name_(receiver_name), time_stamp_(timestamp) {}
-
-    const std::string& receiverName() const { return receiver_name_; }
-    unsigned int timestamp() const { return time_stamp_; }
-
-    std::string receiver_name_;
-    unsigned int time_stamp_;
-
-    WARPED_REGISTER_SERIALIZABLE_MEMBERS(cereal::base_class<warped::Event>(this), 
-                                                        receiver_name_, time_stamp_)
-};
-
 WARPED_REGISTER_POLYMORPHIC_SERIALIZABLE_CLASS(PholdEvent)
 
-class PholdLP : public warped::LogicalProcess {
-public:
-    PholdLP(const std::string& name, unsigned int initial_events,
-                unsigned int num_lps, distribution_t distribution,
-                double distribution_mean = 1.0)
-        : LogicalProcess(name), state_(), initial_events_(initial_events),
-            num_lps_(num_lps), rng_(new std::default_random_engine(rd())),
-            distribution_(distribution), distribution_mean_(distribution_mean) {}
-
-    warped::LPState& getState() { return this->state_; }
-
-    std::vector<std::shared_ptr<warped::Event> > initializeLP() override {
-
-        this->registerRNG(this->rng_);
-
-        std::vector<std::shared_ptr<warped::Event> > events;
-        for (unsigned int i = 0; i < this->initial_events_; i++) {
-            ++this->state_.messages_sent_;
-            events.emplace_back(new PholdEvent { this->get_destination(), 
-                                            this->get_timestamp_delay() });
-        }
-        return events;
-    }
-
-    std::vector<std::shared_ptr<warped::Event>> receiveEvent(const warped::Event& event) {
-        ++this->state_.messages_received_;
-        std::vector<std::shared_ptr<warped::Event> > response_events;
-        auto received_event = static_cast<const PholdEvent&>(event);
-        response_events.emplace_back(new PholdEvent { this->get_destination(),
-                                    event.timestamp() + this->get_timestamp_delay() });
-        ++this->state_.messages_sent_;
-        return response_events;
-    }
-
-    PholdState state_;
-
-protected:
-    const unsigned int initial_events_;
-    const unsigned int num_lps_;
-    std::shared_ptr<std::default_random_engine> rng_;
-    const distribution_t distribution_;
-    const double distribution_mean_;
-
-    std::string get_destination() const {
-        std::uniform_int_distribution<int> dest(0, (int)(num_lps_-1));
-        unsigned int destination_number = (unsigned int) dest(*this->rng_);
-        return std::string("LP ") + std::to_string(destination_number);
-    }
-
-    unsigned int get_timestamp_delay() const {
-        double delay;
-        switch ( this->distribution_ ) {
-            case UNIFORM : {
-                std::uniform_int_distribution<int> uniform(0.0, 2*this->distribution_mean_);
-                delay = uniform(*this->rng_);
-            } break;
-
-            case NORMAL : {
-                std::normal_distribution<double> normal(this->distribution_mean_, 1.0);
-                delay = (unsigned int) normal(*this->rng_);
-            } break;
-
-            case BINOMIAL : {
-                std::binomial_distribution<int> binomial((int)this->distribution_mean_, 0.0);
-                delay = binomial(*this->rng_);
-            } break;
-
-            case POISSON : {
-                std::poisson_distribution<int> poisson((int)this->distribution_mean_);
-                delay = poisson(*this->rng_);
-            } break;
-
-            case EXPONENTIAL : {
-                std::exponential_distribution<double> expo(1.0/this->distribution_mean_);
-                delay = (unsigned int) expo(*this->rng_);
-            } break;
-
-            case FIXED : {
-                delay = (unsigned int) this->distribution_mean_ ;
-            } break;
-
-            default : {
-                delay = 0;
-                std::cerr << "Improper Distribution for a Source LP!!!" << std::endl;
-            }
-        }
-        return ( (unsigned int) delay );
-    }
-};
-
 int main(int argc, const char** argv) {
 
     double distribution_mean = 10.0;
@@ -137,6 +24,15 @@ int main(int argc, const char** argv) {
     unsigned int num_lps = 10000;
     std::string distribution = "EXPONENTIAL";
     std::string log_statistics = "no";
+    unsigned long seed = 0;
+    std::string results_filename = "";
+    std::string trace_filename = "";
+    std::string event_grain = "0";
+    std::string grain_distribution = "FIXED";
+    std::string destination = "UNIFORM";
+    std::string phases = "";
+    std::string phase_filename = "";
+    PholdConfig config;
 
     TCLAP::ValueArg<double> distribution_mean_arg("m", "mean", 
                                                     "mean delay for events", 
@@ -149,14 +45,106 @@ int main(int argc, const char** argv) {
                                                     false, num_lps, "unsigned int");
     TCLAP::ValueArg<std::string> distribution_arg("d", "distribution", "Statistical distribution \
                                                     for timestamp increment\nUNIFORM, POISSON, \
-                                                    EXPONENTIAL, NORMAL, BINOMIAL, or FIXED", 
+                                                    EXPONENTIAL, NORMAL, BINOMIAL, FIXED, \
+                                                    ALTERNATE, ROUNDROBIN, CONDITIONAL, or ALL", 
                                                     false, distribution, "string");
     TCLAP::ValueArg<std::string> log_statistics_arg("l", "log", 
                                                     "Post-simulation log needed - yes or no", 
                                                     false, log_statistics, "string");
+    TCLAP::ValueArg<unsigned long> seed_arg("", "seed", 
+                                                    "Global seed of the per-LP random streams", 
+                                                    false, seed, "unsigned long");
+    TCLAP::ValueArg<std::string> results_arg("", "results", 
+                                                    "Columnar binary file to write each LP's \
+                                                    message counts to", 
+                                                    false, results_filename, "string");
+    TCLAP::ValueArg<std::string> trace_arg("", "trace", 
+                                                    "Binary file to record every processed \
+                                                    event to", 
+                                                    false, trace_filename, "string");
+
+    TCLAP::ValueArg<double> self_fraction_arg("", "self-fraction", 
+                                                    "Fraction of events an LP sends to itself", 
+                                                    false, config.self_fraction_, "double");
+    TCLAP::ValueArg<double> local_fraction_arg("", "local-fraction", 
+                                                    "Fraction of events sent to an LP within \
+                                                    the neighbourhood; the rest go to any LP", 
+                                                    false, config.local_fraction_, "double");
+    TCLAP::ValueArg<unsigned int> neighbourhood_arg("", "neighbourhood", 
+                                                    "Neighbourhood of LP i is i-k..i+k", 
+                                                    false, config.neighbourhood_, "unsigned int");
+    TCLAP::ValueArg<std::string> destination_arg("", "destination", 
+                                                    "How the events that are not local pick \
+                                                    an LP\nUNIFORM or ZIPF", 
+                                                    false, destination, "string");
+    TCLAP::ValueArg<double> zipf_exponent_arg("", "zipf-exponent", 
+                                                    "Exponent of the ZIPF destinations", 
+                                                    false, config.zipf_exponent_, "double");
+    TCLAP::ValueArg<unsigned int> hot_set_period_arg("", "hot-set-period", 
+                                                    "Simulation time between moves of the \
+                                                    ZIPF hot set, 0 for never", 
+                                                    false, config.hot_set_period_, "unsigned int");
+    TCLAP::ValueArg<unsigned int> hot_set_shift_arg("", "hot-set-shift", 
+                                                    "LPs the ZIPF hot set moves on by, 0 for \
+                                                    an eighth of the LPs", 
+                                                    false, config.hot_set_shift_, "unsigned int");
+    TCLAP::ValueArg<std::string> event_grain_arg("", "event-grain", 
+                                                    "Work per event, in floating-point \
+                                                    operations, or in time with an ns or us \
+                                                    suffix, calibrated at startup", 
+                                                    false, event_grain, "string");
+    TCLAP::ValueArg<std::string> grain_distribution_arg("", "grain-distribution", 
+                                                    "Distribution of the event grain over \
+                                                    the LPs\nFIXED, UNIFORM, or EXPONENTIAL", 
+                                                    false, grain_distribution, "string");
+    TCLAP::ValueArg<std::uint32_t> state_bytes_arg("", "state-bytes", 
+                                                    "Bytes of payload in every LP state", 
+                                                    false, config.state_bytes_, "unsigned int");
+    TCLAP::ValueArg<double> state_modified_arg("", "state-modified", 
+                                                    "Fraction of the state payload each \
+                                                    event rewrites", 
+                                                    false, config.state_modified_fraction_, 
+                                                    "double");
+    TCLAP::ValueArg<unsigned int> lookahead_arg("", "lookahead", 
+                                                    "Minimum delay, added to every event's", 
+                                                    false, config.lookahead_, "unsigned int");
+    TCLAP::ValueArg<unsigned int> fanout_arg("", "fanout", 
+                                                    "Events sent in response to one that fans \
+                                                    out", 
+                                                    false, config.fanout_, "unsigned int");
+    TCLAP::ValueArg<double> fanout_probability_arg("", "fanout-probability", 
+                                                    "Probability that an event fans out", 
+                                                    false, config.fanout_probability_, "double");
+    TCLAP::ValueArg<std::uint64_t> population_target_arg("", "population-target", 
+                                                    "Number of pending events to hold the \
+                                                    population near, 0 for no control", 
+                                                    false, config.population_target_, 
+                                                    "unsigned long");
+    TCLAP::ValueArg<std::string> phases_arg("", "phases", 
+                                                    "Phase schedule, e.g. \"1000 \
+                                                    distribution=UNIFORM mean=5; 2000 \
+                                                    remote=0.1 hot-set=5000\"", 
+                                                    false, phases, "string");
+    TCLAP::ValueArg<std::string> phase_file_arg("", "phase-file", 
+                                                    "File with a phase schedule, one phase \
+                                                    per line, # for comments", 
+                                                    false, phase_filename, "string");
+    TCLAP::ValueArg<std::uint32_t> payload_bytes_arg("", "payload-bytes", 
+                                                    "Bytes of payload in every event", 
+                                                    false, config.payload_bytes_, "unsigned int");
 
     std::vector<TCLAP::Arg*> args = {&distribution_mean_arg, &num_initial_events_arg, 
-                                        &num_lps_arg, &distribution_arg, &log_statistics_arg};
+                                        &num_lps_arg, &distribution_arg, &log_statistics_arg, 
+                                        &seed_arg, &results_arg, &trace_arg, 
+                                        &self_fraction_arg, &local_fraction_arg, 
+                                        &neighbourhood_arg, &destination_arg, 
+                                        &zipf_exponent_arg, &hot_set_period_arg, 
+                                        &hot_set_shift_arg, &event_grain_arg, 
+                                        &grain_distribution_arg, &state_bytes_arg, 
+                                        &state_modified_arg, &payload_bytes_arg, 
+                                        &lookahead_arg, &fanout_arg, &fanout_probability_arg, 
+                                        &population_target_arg, &phases_arg, 
+                                        &phase_file_arg};
 
     warped::Simulation phold_sim {"PHOLD Simulation", argc, argv, args};
 
@@ -165,6 +153,105 @@ int main(int argc, const char** argv) {
     num_lps = num_lps_arg.getValue();
     distribution = distribution_arg.getValue();
     log_statistics = log_statistics_arg.getValue();
+    seed = seed_arg.getValue();
+    results_filename = results_arg.getValue();
+    trace_filename = trace_arg.getValue();
+    config.self_fraction_ = self_fraction_arg.getValue();
+    config.local_fraction_ = local_fraction_arg.getValue();
+    config.neighbourhood_ = neighbourhood_arg.getValue();
+    destination = destination_arg.getValue();
+    config.zipf_exponent_ = zipf_exponent_arg.getValue();
+    config.hot_set_period_ = hot_set_period_arg.getValue();
+    config.hot_set_shift_ = hot_set_shift_arg.getValue();
+    event_grain = event_grain_arg.getValue();
+    grain_distribution = grain_distribution_arg.getValue();
+    config.state_bytes_ = state_bytes_arg.getValue();
+    config.state_modified_fraction_ = state_modified_arg.getValue();
+    config.payload_bytes_ = payload_bytes_arg.getValue();
+    config.lookahead_ = lookahead_arg.getValue();
+    config.fanout_ = fanout_arg.getValue();
+    config.fanout_probability_ = fanout_probability_arg.getValue();
+    config.population_target_ = population_target_arg.getValue();
+    phases = phases_arg.getValue();
+    phase_filename = phase_file_arg.getValue();
+
+    if (num_lps == 0) {
+        std::cerr << "Invalid number of LPs. It must be at least 1." << std::endl;
+        exit(1);
+    }
+    if ((config.self_fraction_ < 0.0) || (config.local_fraction_ < 0.0) || 
+            (config.self_fraction_ + config.local_fraction_ > 1.0)) {
+        std::cerr << "Invalid locality. Self and local fractions must be non-negative \
+                                    and add up to at most 1." << std::endl;
+        exit(1);
+    }
+    if (config.neighbourhood_ == 0) {
+        std::cerr << "Invalid neighbourhood. It must be at least 1." << std::endl;
+        exit(1);
+    }
+
+    std::transform(destination.begin(), destination.end(), destination.begin(), toupper);
+    if ((destination != "UNIFORM") && (destination != "ZIPF")) {
+        std::cerr << "Invalid destination argument. It must be UNIFORM or ZIPF." << std::endl;
+        exit(1);
+    }
+    config.zipf_destinations_ = (destination == "ZIPF");
+    if (!(config.zipf_exponent_ >= 0.0)) {
+        std::cerr << "Invalid Zipf exponent. It must be non-negative." << std::endl;
+        exit(1);
+    }
+    if (config.hot_set_shift_ == 0) {
+        config.hot_set_shift_ = std::max(num_lps / 8, 1u);
+    }
+
+    if (!(config.state_modified_fraction_ >= 0.0) || (config.state_modified_fraction_ > 1.0)) {
+        std::cerr << "Invalid state modified fraction. It must be between 0 and 1." << std::endl;
+        exit(1);
+    }
+
+    if (!(config.fanout_probability_ >= 0.0) || (config.fanout_probability_ > 1.0)) {
+        std::cerr << "Invalid fan-out probability. It must be between 0 and 1." << std::endl;
+        exit(1);
+    }
+
+    // A grain given in time is converted once, so that every LP does the
+    // same number of operations however long they take during the run
+    std::size_t grain_digits = 0;
+    double grain = -1.0;
+    try {
+        grain = std::stod(event_grain, &grain_digits);
+    } catch (const std::exception&) {}
+    std::string grain_unit = event_grain.substr(grain_digits);
+    if (!(grain >= 0.0) || ((grain_unit != "") && (grain_unit != "ns") && (grain_unit != "us"))) {
+        std::cerr << "Invalid event grain. It must be a non-negative number of operations, \
+                                    or of nanoseconds or microseconds with an ns or us \
+                                    suffix." << std::endl;
+        exit(1);
+    }
+    if (grain_unit != "") {
+        double flops_per_ns = calibrateFlopsPerNanosecond();
+        double grain_ns = (grain_unit == "us") ? 1000.0 * grain : grain;
+        grain = flops_per_ns * grain_ns;
+        if (phold_sim.isMasterProcess()) {
+            std::cout << "Event grain of " << grain_ns << " ns is " << (std::uint64_t) grain 
+                        << " operations at " << flops_per_ns << " per ns" << std::endl;
+        }
+    }
+    config.event_grain_flops_ = (std::uint64_t) (grain + 0.5);
+
+    std::transform(grain_distribution.begin(), grain_distribution.end(), 
+                                                grain_distribution.begin(), toupper);
+    if (grain_distribution == "FIXED") {
+        config.grain_distribution_ = FIXED;
+    } else if (grain_distribution == "UNIFORM") {
+        config.grain_distribution_ = UNIFORM;
+    } else if (grain_distribution == "EXPONENTIAL") {
+        config.grain_distribution_ = EXPONENTIAL;
+    } else {
+        std::cerr << "Invalid grain distribution argument. It must be FIXED, UNIFORM, \
+                                    or EXPONENTIAL." << std::endl;
+        exit(1);
+    }
 
     std::transform(distribution.begin(), distribution.end(), distribution.begin(), toupper);
     distribution_t dist;
@@ -189,29 +276,143 @@ int main(int argc, const char** argv) {
             std::cerr << "Warning: Fixed timestamp increment less than 1.0 will not \
                                                         advance simulation." << std::endl;
         }
+    } else if ( distribution == "ALTERNATE" ) {
+        dist = ALTERNATE;
+    } else if ( distribution == "ROUNDROBIN" ) {
+        dist = ROUNDROBIN;
+    } else if ( distribution == "CONDITIONAL" ) {
+        dist = CONDITIONAL;
+        if ( distribution_mean <= 1.0 ) {
+            std::cerr << "Warning: Conditional distribution needs mean > 1.0." << std::endl;
+        }
+    } else if ( distribution == "ALL" ) {
+        dist = ALL;
     } else {
         std::cerr << "Invalid distribution argument. It must be UNIFORM, POISSON, \
-                                    EXPONENTIAL, NORMAL, BINOMIAL, or FIXED." << std::endl;
+                                    EXPONENTIAL, NORMAL, BINOMIAL, FIXED, ALTERNATE, \
+                                    ROUNDROBIN, CONDITIONAL, or ALL." << std::endl;
         exit(1);
     }
 
-    std::vector<PholdLP> lps;
-    for (unsigned int i = 0; i < num_lps; i++) {
-        std::string name = std::string("LP ") + std::to_string(i);
-        lps.emplace_back(name, num_initial_events, num_lps, dist, distribution_mean);
+    // A phase file becomes one line of the same schedule syntax
+    if (!phase_filename.empty()) {
+        std::ifstream phase_file(phase_filename);
+        if (!phase_file.is_open()) {
+            std::cerr << "Could not open phase file - " << phase_filename << std::endl;
+            exit(1);
+        }
+        std::string line;
+        while (std::getline(phase_file, line)) {
+            phases += ";" + line.substr(0, line.find('#'));
+        }
+    }
+    std::string phase_error;
+    if (!parsePholdPhases(phases, dist, distribution_mean, config, config.phases_, 
+                                                                        phase_error)) {
+        std::cerr << "Invalid phase schedule: " << phase_error << std::endl;
+        exit(1);
     }
 
-    std::vector<warped::LogicalProcess*> lp_pointers;
-    for (auto& lp : lps) {
-        lp_pointers.push_back(&lp);
+    LPNameRegistry lp_names {"LP ", num_lps};
+
+    PholdRun run {lp_names, num_initial_events, seed, dist, distribution_mean, config};
+    LPArray<PholdLP> lps {num_lps, run};
+
+    TraceWriter trace;
+    if (!trace_filename.empty()) {
+        // Every digit, so that a replay builds exactly the same LPs
+        auto exact = [](double value) {
+            std::ostringstream text;
+            text.precision(17);
+            text << value;
+            return text.str();
+        };
+
+        if (!trace.open(trace_filename, "phold", {
+                {"num_lps", std::to_string(num_lps)},
+                {"events", std::to_string(num_initial_events)},
+                {"distribution", distribution},
+                {"mean", exact(distribution_mean)},
+                {"seed", std::to_string(seed)},
+                {"self-fraction", exact(config.self_fraction_)},
+                {"local-fraction", exact(config.local_fraction_)},
+                {"neighbourhood", std::to_string(config.neighbourhood_)},
+                {"destination", destination},
+                {"zipf-exponent", exact(config.zipf_exponent_)},
+                {"hot-set-period", std::to_string(config.hot_set_period_)},
+                {"hot-set-shift", std::to_string(config.hot_set_shift_)},
+                {"event-grain", std::to_string(config.event_grain_flops_)},
+                {"grain-distribution", grain_distribution},
+                {"state-bytes", std::to_string(config.state_bytes_)},
+                {"state-modified", exact(config.state_modified_fraction_)},
+                {"payload-bytes", std::to_string(config.payload_bytes_)},
+                {"lookahead", std::to_string(config.lookahead_)},
+                {"fanout", std::to_string(config.fanout_)},
+                {"fanout-probability", exact(config.fanout_probability_)},
+                {"population-target", std::to_string(config.population_target_)},
+                {"phases", phases},
+                {"phase-count", std::to_string(config.phases_.size())}})) {
+            std::cerr << "Could not create trace file - " << trace_filename << std::endl;
+            return 1;
+        }
+        run.recordTo(&trace);
     }
 
+    std::vector<warped::LogicalProcess*> lp_pointers = lps.pointers<warped::LogicalProcess>();
+
     phold_sim.simulate(lp_pointers);
+    PholdProfile::report("phold", kPholdEventNames);
+
+    if (phold_sim.isMasterProcess()) {
+        unsigned int min_delay = std::numeric_limits<unsigned int>::max();
+        std::uint64_t total_delay = 0, num_sent = 0;
+        for (auto& lp : lps) {
+            min_delay = std::min(min_delay, lp.state_.min_delay_);
+            total_delay += lp.state_.total_delay_;
+            num_sent += lp.state_.messages_sent_;
+        }
+        if (num_sent) {
+            std::cout << "Lookahead " << min_delay << " achieved (" << config.lookahead_ 
+                        << " required), mean delay " << (double) total_delay / num_sent 
+                        << std::endl;
+        }
+        if (config.fanout_probability_ || config.population_target_) {
+            std::int64_t population = 0;
+            for (auto& lp : lps) {
+                population += (std::int64_t) lp.state_.messages_sent_ 
+                                                - (std::int64_t) lp.state_.messages_received_;
+            }
+            std::cout << "Event population " << population << " at the end (target " 
+                        << config.population_target_ << ")" << std::endl;
+        }
+    }
+
+    if (trace.isOpen()) {
+        std::uint64_t dropped = trace.numDropped();
+        if (!trace.close() || dropped) {
+            std::cerr << "Trace file " << trace_filename << " is incomplete, " 
+                                    << dropped << " events not recorded" << std::endl;
+        }
+    }
 
     if (log_statistics == "yes") {
         for (auto& lp : lps) {
             std::cout << lp.name_ << " sent " << lp.state_.messages_sent_ << " and received "
-                                << lp.state_.messages_received_ << " messages." << std::endl;
+                                << lp.state_.messages_received_ << " messages.\n";
+        }
+        std::cout.flush();
+    }
+
+    if (phold_sim.isMasterProcess() && !results_filename.empty()) {
+        ResultsWriter results {lps.size()};
+        results.addColumn<std::uint32_t>("messages_sent", 
+                        [&](std::uint64_t i) { return lps[i].state_.messages_sent_; });
+        results.addColumn<std::uint32_t>("messages_received", 
+                        [&](std::uint64_t i) { return lps[i].state_.messages_received_; });
+        results.addColumn<std::uint32_t>("min_delay", 
+                        [&](std::uint64_t i) { return lps[i].state_.min_delay_; });
+        if (!results.write(results_filename)) {
+            std::cerr << "Could not write results file - " << results_filename << std::endl;
         }
     }
 
@@ -2,751 +2,356 @@
 // https://github.com/carothersc/ROSS-Models/blob/master/traffic/
 
 #include <cassert>
-#include <random>
+#include <cmath>
+#include <sstream>
 #include "traffic.hpp"
-#include "tclap/ValueArg.h"
-
-#define MAX_CARS_ON_ROAD 5
+#include "utility/memory.hpp"
 
 WARPED_REGISTER_POLYMORPHIC_SERIALIZABLE_CLASS(TrafficState)
 WARPED_REGISTER_POLYMORPHIC_SERIALIZABLE_CLASS(TrafficEvent)
 
+bool parseSignalTimings(const std::string& timings, TrafficSignalPlan& plan) {
+
+    plan.green_.clear();
+    std::istringstream list(timings);
+    std::string green;
+    while (std::getline(list, green, ',')) {
+        std::size_t digits = 0;
+        unsigned long value = 0;
+        try {
+            value = std::stoul(green, &digits);
+        } catch (const std::exception&) {}
+        if (!digits || (digits != green.size()) || !value || (value > UINT32_MAX)) {
+            return false;
+        }
+        plan.green_.push_back((unsigned int) value);
+    }
+    return plan.green_.empty() || (plan.green_.size() == 2) || (plan.green_.size() == kNumRoads);
+}
+
 std::vector<std::shared_ptr<warped::Event> > Intersection::initializeLP() {
 
     this->registerRNG(this->rng_);
 
-    std::exponential_distribution<double> interval_expo(1.0/this->mean_interval_);
-
-    std::uniform_int_distribution<unsigned int> rand_car_direction(0,11);
+    UniformIntSampler rand_car_direction(0,11);
     auto car_arrival = (car_direction_t) rand_car_direction(*this->rng_);
     auto car_current_lane = car_arrival;
 
-    std::uniform_int_distribution<int> rand_x(-99,100);
-    std::uniform_int_distribution<int> rand_y(-99,100);
+    UniformIntSampler rand_x(-99,100);
+    UniformIntSampler rand_y(-99,100);
 
     std::vector<std::shared_ptr<warped::Event> > events;
     for (unsigned int i = 0; i < this->num_cars_; i++) {
-        events.emplace_back(new TrafficEvent {
-                lp_name(this->index_), ARRIVAL, rand_x(*this->rng_), rand_y(*this->rng_), 
-                car_arrival, car_current_lane, (unsigned int) std::ceil(interval_expo(*this->rng_))});
+        int x_to_go = (int) rand_x(*this->rng_);
+        int y_to_go = (int) rand_y(*this->rng_);
+        auto timestamp = (unsigned int) std::ceil(interval_expo_(*this->rng_));
+        std::uint64_t car_id = ((std::uint64_t) index_ << 32) | i;
+        events.emplace_back(make_event<TrafficEvent>(this->name_, ARRIVAL, x_to_go, y_to_go, 
+                            car_arrival, car_current_lane, car_id, timestamp, timestamp));
+    }
+
+    if (signals_.enabled()) {
+        std::uint64_t next_change;
+        this->signal_phase(0, next_change);
+        if (next_change < UINT32_MAX) {
+            events.emplace_back(make_event<TrafficEvent>(this->name_, SIGNAL, 0, 0, 
+                                    NORTH_LEFT, NORTH_LEFT, 0, 0, (unsigned int) next_change));
+        }
+    }
+
+    if (demand_.rate(index_) > 0.0) {
+        this->schedule_source(events, demand_.nextDeparture(0.0, index_, *this->rng_));
     }
     return events;
 }
 
-inline std::string Intersection::lp_name(const unsigned int lp_index) {
-
-    return std::string("Intersection_") + std::to_string(lp_index);
+void Intersection::schedule_source(std::vector<std::shared_ptr<warped::Event>>& events, 
+                                                                                double due) {
+    double timestamp = std::ceil(due);
+    if (timestamp < UINT32_MAX) {
+        events.emplace_back(make_event<TrafficEvent>(this->name_, SOURCE, 0, 0, NORTH_LEFT, 
+                                NORTH_LEFT, 0, 0, (unsigned int) timestamp, false, due));
+    }
 }
 
+// One exit a car may take at DIRECTION_SELECT: the outgoing lane, and the
+// coordinate (0 for x, 1 for y) and sign of the distance it brings the car
+// closer along. It is taken only if that distance is non-zero with this sign.
+struct LaneExit {
+    unsigned char axis_;
+    signed char sign_;
+    car_direction_t lane_;
+};
+
+// What happens to a car on each lane, indexed by car_direction_t
+struct LaneTransition {
+    car_direction_t arrival_lane_;  // ARRIVAL: incoming lane of a car sent on this lane
+    direction_t departure_;         // DEPARTURE: the neighbour this lane leads to
+    LaneExit exits_[3];             // DIRECTION_SELECT: outgoing lanes by preference
+};
+
+constexpr LaneTransition kLaneTransitions[kNumRoads * kNumLanes] = {
+    {SOUTH_LEFT,     NORTH, {{0, 1, EAST_STRAIGHT},  {1, 1, EAST_LEFT},    {1, -1, EAST_RIGHT}}},
+    {SOUTH_STRAIGHT, NORTH, {{1, -1, SOUTH_STRAIGHT}, {0, 1, SOUTH_LEFT},  {0, -1, SOUTH_RIGHT}}},
+    {SOUTH_RIGHT,    NORTH, {{0, -1, WEST_STRAIGHT}, {1, -1, WEST_LEFT},   {1, 1, WEST_RIGHT}}},
+    {NORTH_LEFT,     SOUTH, {{0, -1, WEST_STRAIGHT}, {1, -1, WEST_LEFT},   {1, 1, WEST_RIGHT}}},
+    {NORTH_STRAIGHT, SOUTH, {{1, 1, NORTH_STRAIGHT}, {0, -1, NORTH_LEFT},  {0, 1, NORTH_RIGHT}}},
+    {NORTH_RIGHT,    SOUTH, {{0, 1, EAST_STRAIGHT},  {1, 1, EAST_LEFT},    {1, -1, EAST_RIGHT}}},
+    {WEST_LEFT,      EAST,  {{1, -1, SOUTH_STRAIGHT}, {0, -1, SOUTH_RIGHT}, {0, 1, SOUTH_LEFT}}},
+    {WEST_STRAIGHT,  EAST,  {{0, -1, WEST_STRAIGHT}, {1, -1, WEST_LEFT},   {1, 1, WEST_RIGHT}}},
+    {WEST_RIGHT,     EAST,  {{1, 1, NORTH_STRAIGHT}, {0, 1, NORTH_RIGHT},  {0, -1, NORTH_LEFT}}},
+    {EAST_LEFT,      WEST,  {{1, 1, NORTH_STRAIGHT}, {0, 1, NORTH_RIGHT},  {0, -1, NORTH_LEFT}}},
+    {EAST_STRAIGHT,  WEST,  {{0, 1, EAST_STRAIGHT},  {1, 1, EAST_LEFT},    {1, -1, EAST_RIGHT}}},
+    {EAST_RIGHT,     WEST,  {{1, -1, SOUTH_STRAIGHT}, {0, 1, SOUTH_LEFT},  {0, -1, SOUTH_RIGHT}}}
+};
+
+// The lane a car turns back onto when none of its exits has room, by the road
+// it is on and the lane it arrived from. A car from any other lane keeps its
+// lane and goes out on it even though the road is full.
+const signed char kStay = -1;
+constexpr signed char kFallbackLane[kNumRoads][kNumRoads * kNumLanes] = {
+    // NORTH_LEFT ... WEST_RIGHT
+    {kStay, NORTH_STRAIGHT, kStay, kStay, kStay, kStay,
+                            NORTH_RIGHT, kStay, kStay, kStay, kStay, NORTH_LEFT},
+    {kStay, kStay, kStay, kStay, SOUTH_STRAIGHT, kStay,
+                            kStay, kStay, SOUTH_LEFT, SOUTH_RIGHT, kStay, kStay},
+    {kStay, kStay, EAST_LEFT, EAST_RIGHT, kStay, kStay,
+                            kStay, EAST_STRAIGHT, kStay, kStay, kStay, kStay},
+    {WEST_RIGHT, kStay, kStay, kStay, kStay, WEST_LEFT,
+                            kStay, kStay, kStay, kStay, WEST_STRAIGHT, kStay}
+};
+
 std::vector<std::shared_ptr<warped::Event> > 
                 Intersection::receiveEvent(const warped::Event& event) {
 
     std::vector<std::shared_ptr<warped::Event> > events;
-    auto traffic_event = static_cast<const TrafficEvent&>(event);
-    std::exponential_distribution<double> interval_expo(1.0/this->mean_interval_);
+    const auto& traffic_event = static_cast<const TrafficEvent&>(event);
+    if (this->trace_) {
+        this->trace_->record(index_, traffic_event.type_, traffic_event);
+    }
+    auto profile = IntersectionProfile::start(traffic_event.type_);
+    const LaneTransition& transition = kLaneTransitions[traffic_event.current_lane_];
 
     switch (traffic_event.type_) {
 
         case ARRIVAL: {
 
             if (!traffic_event.x_to_go_ && !traffic_event.y_to_go_) {
+                unsigned int trip_time = traffic_event.ts_ - traffic_event.departed_;
                 state_.total_cars_finished_++;
+                state_.total_trip_time_ += trip_time;
+                state_.trip_times_.add(trip_time, trip_bucket_width_);
                 break;
             }
-            car_direction_t arrival_from = traffic_event.current_lane_;
+            CarInLane car {traffic_event.car_id_, traffic_event.departed_, 
+                            traffic_event.x_to_go_, traffic_event.y_to_go_, 
+                            traffic_event.arrived_from_, transition.arrival_lane_, 
+                            traffic_event.routed_};
             state_.total_cars_arrived_++;
-
-            switch (traffic_event.current_lane_) {
-
-                case WEST_LEFT: {
-                    state_.num_in_east_left_++;
-                    arrival_from = EAST_LEFT;
-                } break;
-
-                case WEST_STRAIGHT: {
-                    state_.num_in_east_straight_++;
-                    arrival_from = EAST_STRAIGHT;
-                } break;
-
-                case WEST_RIGHT: {
-                    state_.num_in_east_right_++;
-                    arrival_from = EAST_RIGHT;
-                } break;
-
-                case EAST_LEFT: {
-                    state_.num_in_west_left_++;
-                    arrival_from = WEST_LEFT;
-                } break;
-
-                case EAST_STRAIGHT: {
-                    state_.num_in_west_straight_++;
-                    arrival_from = WEST_STRAIGHT;
-                } break;
-
-                case EAST_RIGHT: {
-                    state_.num_in_west_right_++;
-                    arrival_from = WEST_RIGHT;
-                } break;
-
-                case NORTH_LEFT: {
-                    state_.num_in_south_left_++;
-                    arrival_from = SOUTH_LEFT;
-                } break;
-
-                case NORTH_STRAIGHT: {
-                    state_.num_in_south_straight_++;
-                    arrival_from = SOUTH_STRAIGHT;
-                } break;
-
-                case NORTH_RIGHT: {
-                    state_.num_in_south_right_++;
-                    arrival_from = SOUTH_RIGHT;
-                } break;
-
-                case SOUTH_LEFT: {
-                    state_.num_in_north_left_++;
-                    arrival_from = NORTH_LEFT;
-                } break;
-
-                case SOUTH_STRAIGHT: {
-                    state_.num_in_north_straight_++;
-                    arrival_from = NORTH_STRAIGHT;
-                } break;
-
-                case SOUTH_RIGHT: {
-                    state_.num_in_north_right_++;
-                    arrival_from = NORTH_RIGHT;
-                } break;
+            state_.numIn(transition.arrival_lane_)++;
+
+            if (signals_.enabled()) {
+                // The car crosses on green and waits on red
+                std::uint64_t next_change;
+                unsigned int phase = this->signal_phase(traffic_event.ts_, next_change);
+                if (signals_.greenPhase(car.lane_ / kNumLanes) == phase) {
+                    this->select_direction(events, traffic_event.ts_, car);
+                } else {
+                    state_.waiting_.push_back(car);
+                }
+                break;
             }
 
-            auto timestamp = traffic_event.ts_ + (unsigned int) std::ceil(interval_expo(*this->rng_));
-            events.emplace_back(new TrafficEvent {
-                            this->name_, DIRECTION_SELECT, 
-                            traffic_event.x_to_go_, traffic_event.y_to_go_, 
-                            traffic_event.arrived_from_, arrival_from, timestamp});
+            auto timestamp = traffic_event.ts_ + (unsigned int) std::ceil(interval_expo_(*this->rng_));
+            events.emplace_back(make_event<TrafficEvent>(
+                            this->name_, DIRECTION_SELECT, car.x_to_go_, car.y_to_go_, 
+                            car.arrived_from_, car.lane_, car.car_id_, car.departed_, timestamp, 
+                            car.routed_));
         } break;
 
 
         case DEPARTURE: {
 
-            direction_t departure_direction = NORTH;
-            switch (traffic_event.current_lane_) {
-
-                case WEST_LEFT: {
-                    state_.num_out_west_left_--;
-                    departure_direction = WEST;
-                } break;
-
-                case WEST_STRAIGHT: {
-                    state_.num_out_west_straight_--;
-                    departure_direction = WEST;
-                } break;
-
-                case WEST_RIGHT: {
-                    state_.num_out_west_right_--;
-                    departure_direction = WEST;
-                } break;
-
-                case EAST_LEFT: {
-                    state_.num_out_east_left_--;
-                    departure_direction = EAST;
-                } break;
-
-                case EAST_STRAIGHT: {
-                    state_.num_out_east_straight_--;
-                    departure_direction = EAST;
-                } break;
-
-                case EAST_RIGHT: {
-                    state_.num_out_east_right_--;
-                    departure_direction = EAST;
-                } break;
-
-                case NORTH_LEFT: {
-                    state_.num_out_north_left_--;
-                    departure_direction = NORTH;
-                } break;
-
-                case NORTH_STRAIGHT: {
-                    state_.num_out_north_straight_--;
-                    departure_direction = NORTH;
-                } break;
-
-                case NORTH_RIGHT: {
-                    state_.num_out_north_right_--;
-                    departure_direction = NORTH;
-                } break;
-
-                case SOUTH_LEFT: {
-                    state_.num_out_south_left_--;
-                    departure_direction = SOUTH;
-                } break;
-
-                case SOUTH_STRAIGHT: {
-                    state_.num_out_south_straight_--;
-                    departure_direction = SOUTH;
-                } break;
-
-                case SOUTH_RIGHT: {
-                    state_.num_out_south_right_--;
-                    departure_direction = SOUTH;
-                } break;
+            state_.numOut(traffic_event.current_lane_)--;
+
+            // A dead end turns the car back into the intersection it left
+            const std::string* next_name = &this->name_;
+            unsigned int length = 0;
+            if (this->num_side_roads(transition.departure_)) {
+                std::uint32_t road = this->choose_road(transition.departure_);
+                next_name = &lp_names_[network_.target(road)];
+                length = network_.length(road);
             }
 
-            auto timestamp = traffic_event.ts_ + (unsigned int) std::ceil(interval_expo(*this->rng_));
-            events.emplace_back(new TrafficEvent {
-                            this->compute_move(departure_direction), ARRIVAL, 
+            auto timestamp = traffic_event.ts_ + length + 
+                                    (unsigned int) std::ceil(interval_expo_(*this->rng_));
+            events.emplace_back(make_event<TrafficEvent>(
+                            *next_name, ARRIVAL, 
                             traffic_event.x_to_go_, traffic_event.y_to_go_, 
-                            traffic_event.arrived_from_, traffic_event.current_lane_, timestamp});
+                            traffic_event.arrived_from_, traffic_event.current_lane_, 
+                            traffic_event.car_id_, traffic_event.departed_, timestamp, 
+                            traffic_event.routed_));
         } break;
 
 
         case DIRECTION_SELECT: {
 
-            int x_to_go = traffic_event.x_to_go_;
-            int y_to_go = traffic_event.y_to_go_;
-            car_direction_t current_lane = traffic_event.current_lane_;
-
-            switch (traffic_event.current_lane_) {
-
-                case EAST_LEFT: {
-                    state_.num_in_east_left_--;
-                    if ((y_to_go < 0) && 
-                                (state_.num_out_south_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = SOUTH_STRAIGHT;
-                        state_.num_out_south_straight_++;
-                        y_to_go++;
-
-                    } else if ((x_to_go < 0) && 
-                                (state_.num_out_south_right_ < MAX_CARS_ON_ROAD)){
-                        current_lane = SOUTH_RIGHT;
-                        state_.num_out_south_right_++;
-                        x_to_go++;
-
-                    } else if ((x_to_go > 0) && 
-                                (state_.num_out_south_left_ < MAX_CARS_ON_ROAD)){
-                        current_lane = SOUTH_LEFT;
-                        state_.num_out_south_left_++;
-                        x_to_go--;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == SOUTH_LEFT) {
-                            current_lane = EAST_RIGHT;
-                            state_.num_out_east_right_++;
-
-                        } else if (traffic_event.arrived_from_ == EAST_STRAIGHT) {
-                            current_lane = EAST_STRAIGHT;
-                            state_.num_out_east_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == NORTH_RIGHT) {
-                            current_lane = EAST_LEFT;
-                            state_.num_out_east_left_++;
-                        }
-                    }
-                } break;
-
-                case EAST_STRAIGHT: {
-                    state_.num_in_east_straight_--;
-                    if ((x_to_go < 0) && 
-                                (state_.num_out_west_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = WEST_STRAIGHT;
-                        state_.num_out_west_straight_++;
-                        x_to_go++;
-
-                    } else if ((y_to_go < 0) && 
-                                (state_.num_out_west_left_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = WEST_LEFT;
-                        state_.num_out_west_left_++;
-                        y_to_go++;
-
-                    } else if ((y_to_go > 0) && 
-                                (state_.num_out_west_right_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = WEST_RIGHT;
-                        state_.num_out_west_right_++;
-                        y_to_go--;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == NORTH_RIGHT) {
-                            current_lane = EAST_LEFT;
-                            state_.num_out_east_left_++;
-
-                        } else if (traffic_event.arrived_from_ == EAST_STRAIGHT) {
-                            current_lane = EAST_STRAIGHT;
-                            state_.num_out_east_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == SOUTH_LEFT) {
-                            current_lane = EAST_RIGHT;
-                            state_.num_out_east_right_++;
-                        }
-                    }
-                } break;
-
-                case EAST_RIGHT: {
-                    state_.num_in_east_right_--;
-                    if ((y_to_go > 0) && 
-                                (state_.num_out_north_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = NORTH_STRAIGHT;
-                        state_.num_out_north_straight_++;
-                        y_to_go--;
-
-                    } else if ((x_to_go > 0) && 
-                                (state_.num_out_north_right_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = NORTH_RIGHT;
-                        state_.num_out_north_right_++;
-                        x_to_go --;
-
-                    } else if ((x_to_go < 0) && 
-                                (state_.num_out_north_left_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = NORTH_LEFT;
-                        state_.num_out_north_left_++;
-                        x_to_go++;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == SOUTH_LEFT) {
-                            current_lane = EAST_RIGHT;
-                            state_.num_out_east_right_++;
-
-                        } else if (traffic_event.arrived_from_ == EAST_STRAIGHT) {
-                            current_lane = EAST_STRAIGHT;
-                            state_.num_out_east_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == NORTH_RIGHT) {
-                            current_lane = EAST_LEFT;
-                            state_.num_out_east_left_++;
-                        }
-                    }
-                } break;
-
-                case WEST_LEFT: {
-                    state_.num_in_west_left_--;
-                    if ((y_to_go > 0) && 
-                                (state_.num_out_north_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = NORTH_STRAIGHT;
-                        state_.num_out_north_straight_++;
-                        y_to_go--;
-
-                    } else if ((x_to_go > 0) && 
-                                (state_.num_out_north_right_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = NORTH_RIGHT;
-                        state_.num_out_north_right_++;
-                        x_to_go--;
-
-                    } else if ((x_to_go < 0) && 
-                                (state_.num_out_north_left_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = NORTH_LEFT;
-                        state_.num_out_north_left_++;
-                        x_to_go++;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == SOUTH_RIGHT) {
-                            current_lane = WEST_LEFT;
-                            state_.num_out_west_left_++;
-
-                        } else if (traffic_event.arrived_from_ == WEST_STRAIGHT) {
-                            current_lane = WEST_STRAIGHT;
-                            state_.num_out_west_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == NORTH_LEFT) {
-                            current_lane = WEST_RIGHT;
-                            state_.num_out_west_right_++;
-                        }
-                    }
-                } break;
-
-                case WEST_STRAIGHT: {
-                    state_.num_in_west_straight_--;
-                    if ((x_to_go > 0) && 
-                                (state_.num_out_east_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = EAST_STRAIGHT;
-                        state_.num_out_east_straight_++;
-                        x_to_go--;
-
-                    } else if ((y_to_go > 0) && 
-                                (state_.num_out_east_left_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = EAST_LEFT;
-                        state_.num_out_east_left_++;
-                        y_to_go --;
-
-                    } else if ((y_to_go < 0) && 
-                                (state_.num_out_east_right_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = EAST_RIGHT;
-                        state_.num_out_east_right_++;
-                        y_to_go++;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == SOUTH_RIGHT) {
-                            current_lane = WEST_LEFT;
-                            state_.num_out_west_left_++;
-
-                        } else if (traffic_event.arrived_from_ == WEST_STRAIGHT) {
-                            current_lane = WEST_STRAIGHT;
-                            state_.num_out_west_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == NORTH_LEFT) {
-                            current_lane = WEST_RIGHT;
-                            state_.num_out_west_right_++;
-                        }
-                    }
-                } break;
-
-                case WEST_RIGHT: {
-                    state_.num_in_west_right_--;
-                    if ((y_to_go < 0) && 
-                                (state_.num_out_south_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = SOUTH_STRAIGHT;
-                        state_.num_out_south_straight_++;
-                        y_to_go++;
-
-                    } else if ((x_to_go > 0) && 
-                                (state_.num_out_south_left_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = SOUTH_LEFT;
-                        state_.num_out_south_left_++;
-                        x_to_go--;
-
-                    } else if ((x_to_go < 0) && 
-                                (state_.num_out_south_right_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = SOUTH_RIGHT;
-                        state_.num_out_south_right_++;
-                        x_to_go++;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == SOUTH_RIGHT) {
-                            current_lane = WEST_LEFT;
-                            state_.num_out_west_left_++;
-
-                        } else if (traffic_event.arrived_from_ == WEST_STRAIGHT) {
-                            current_lane = WEST_STRAIGHT;
-                            state_.num_out_west_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == NORTH_LEFT) {
-                            current_lane = WEST_RIGHT;
-                            state_.num_out_west_right_++;
-                        }
-                    }
-                } break;
-
-                case NORTH_LEFT: {
-                    state_.num_in_north_left_--;
-                    if ((x_to_go > 0) && 
-                                (state_.num_out_east_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = EAST_STRAIGHT;
-                        state_.num_out_east_straight_++;
-                        x_to_go--;
-
-                    } else if ((y_to_go > 0) && 
-                                (state_.num_out_east_left_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = EAST_LEFT;
-                        state_.num_out_east_left_++;
-                        y_to_go--;
-
-                    } else if ((y_to_go < 0) && 
-                                (state_.num_out_east_right_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = EAST_RIGHT;
-                        state_.num_out_east_right_++;
-                        y_to_go++;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == WEST_RIGHT) {
-                            current_lane = NORTH_LEFT;
-                            state_.num_out_north_left_++;
-
-                        } else if (traffic_event.arrived_from_ == NORTH_STRAIGHT) {
-                            current_lane = NORTH_STRAIGHT;
-                            state_.num_out_north_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == EAST_LEFT) {
-                            current_lane = NORTH_RIGHT;
-                            state_.num_out_north_right_++;
-                        }
-                    }
-                } break;
-
-                case NORTH_STRAIGHT: {
-                    state_.num_in_north_straight_--;
-                    if ((y_to_go < 0) && 
-                                (state_.num_out_south_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = SOUTH_STRAIGHT;
-                        state_.num_out_south_straight_++;
-                        y_to_go++;
-
-                    } else if ((x_to_go > 0) && 
-                                (state_.num_out_south_left_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = SOUTH_LEFT;
-                        state_.num_out_south_left_++;
-                        x_to_go--;
-
-                    } else if ((x_to_go < 0) && 
-                                (state_.num_out_south_right_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = SOUTH_RIGHT;
-                        state_.num_out_south_right_++;
-                        x_to_go++;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == WEST_RIGHT) {
-                            current_lane = NORTH_LEFT;
-                            state_.num_out_north_left_++;
-
-                        } else if (traffic_event.arrived_from_ == NORTH_STRAIGHT) {
-                            current_lane = NORTH_STRAIGHT;
-                            state_.num_out_north_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == EAST_LEFT) {
-                            current_lane = NORTH_RIGHT;
-                            state_.num_out_north_right_++;
-                        }
-                    }
-                } break;
-
-                case NORTH_RIGHT: {
-                    state_.num_in_north_right_--;
-                    if ((x_to_go < 0) && 
-                                (state_.num_out_west_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = WEST_STRAIGHT;
-                        state_.num_out_west_straight_++;
-                        x_to_go++;
-
-                    } else if ((y_to_go < 0) && 
-                                (state_.num_out_west_left_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = WEST_LEFT;
-                        state_.num_out_west_left_++;
-                        y_to_go++;
-
-                    } else if ((y_to_go > 0) && 
-                                (state_.num_out_west_right_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = WEST_RIGHT;
-                        state_.num_out_west_right_++;
-                        y_to_go--;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == WEST_RIGHT) {
-                            current_lane = NORTH_LEFT;
-                            state_.num_out_north_left_++;
-
-                        } else if (traffic_event.arrived_from_ == NORTH_STRAIGHT) {
-                            current_lane = NORTH_STRAIGHT;
-                            state_.num_out_north_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == EAST_LEFT) {
-                            current_lane = NORTH_RIGHT;
-                            state_.num_out_north_right_++;
-                        }
-                    }
-                } break;
-
-                case SOUTH_LEFT: {
-                    state_.num_in_south_left_--;
-                    if ((x_to_go < 0) && 
-                                (state_.num_out_west_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = WEST_STRAIGHT;
-                        state_.num_out_west_straight_++;
-                        x_to_go++;
-
-                    } else if ((y_to_go < 0) && 
-                                (state_.num_out_west_left_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = WEST_LEFT;
-                        state_.num_out_west_left_++;
-                        y_to_go++;
-
-                    } else if ((y_to_go > 0) && 
-                                (state_.num_out_west_right_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = WEST_RIGHT;
-                        state_.num_out_west_right_++;
-                        y_to_go--;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == WEST_LEFT) {
-                            current_lane = SOUTH_RIGHT;
-                            state_.num_out_south_right_++;
-
-                        } else if (traffic_event.arrived_from_ == SOUTH_STRAIGHT) {
-                            current_lane = SOUTH_STRAIGHT;
-                            state_.num_out_south_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == EAST_RIGHT) {
-                            current_lane = SOUTH_LEFT;
-                            state_.num_out_south_left_++;
-                        }
-                    }
-                } break;
-
-                case SOUTH_STRAIGHT: {
-                    state_.num_in_south_straight_--;
-                    if ((y_to_go > 0) && 
-                                (state_.num_out_north_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = NORTH_STRAIGHT;
-                        state_.num_out_north_straight_++;
-                        y_to_go--;
-
-                    } else if ((x_to_go < 0) && 
-                                (state_.num_out_north_left_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = NORTH_LEFT;
-                        state_.num_out_north_left_++;
-                        x_to_go++;
-
-                    } else if ((x_to_go > 0) && 
-                                (state_.num_out_north_right_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = NORTH_RIGHT;
-                        state_.num_out_north_right_++;
-                        x_to_go --;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == EAST_RIGHT) {
-                            current_lane = SOUTH_LEFT;
-                            state_.num_out_south_left_++;
-
-                        } else if (traffic_event.arrived_from_ == SOUTH_STRAIGHT) {
-                            current_lane = SOUTH_STRAIGHT;
-                            state_.num_out_south_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == WEST_LEFT) {
-                            current_lane = SOUTH_RIGHT;
-                            state_.num_out_south_right_++;
-                        }
-                    }
-                } break;
-
-                case SOUTH_RIGHT: {
-                    state_.num_in_south_right_--;
-                    if ((x_to_go > 0) && 
-                                (state_.num_out_east_straight_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = EAST_STRAIGHT;
-                        state_.num_out_east_straight_++;
-                        x_to_go--;
-
-                    } else if ((y_to_go > 0) && 
-                                (state_.num_out_east_left_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = EAST_LEFT;
-                        state_.num_out_east_left_++;
-                        y_to_go--;
-
-                    } else if ((y_to_go < 0) && 
-                                (state_.num_out_east_right_ < MAX_CARS_ON_ROAD)) {
-                        current_lane = EAST_RIGHT;
-                        state_.num_out_east_right_++;
-                        y_to_go++;
-
-                    } else {
-                        if (traffic_event.arrived_from_ == EAST_RIGHT) {
-                            current_lane = SOUTH_LEFT;
-                            state_.num_out_south_left_++;
-
-                        } else if (traffic_event.arrived_from_ == SOUTH_STRAIGHT) {
-                            current_lane = SOUTH_STRAIGHT;
-                            state_.num_out_south_straight_++;
-
-                        } else if (traffic_event.arrived_from_ == WEST_LEFT) {
-                            current_lane = SOUTH_RIGHT;
-                            state_.num_out_south_right_++;
-                        }
-                    }
-                } break;
-            }
-
-            auto timestamp = traffic_event.ts_ + (unsigned int) std::ceil(interval_expo(*this->rng_));
-            events.emplace_back(new TrafficEvent {
-                            this->name_, DEPARTURE, x_to_go, y_to_go, 
-                            traffic_event.current_lane_, current_lane, timestamp});
+            this->select_direction(events, traffic_event.ts_, CarInLane {
+                            traffic_event.car_id_, traffic_event.departed_, 
+                            traffic_event.x_to_go_, traffic_event.y_to_go_, 
+                            traffic_event.arrived_from_, traffic_event.current_lane_, 
+                            traffic_event.routed_});
         } break;
 
-        default: {
-            assert(0);
-        }
-    }
-    return events;
-}
 
-std::string Intersection::compute_move(direction_t direction) {
+        case SIGNAL: {
 
-    unsigned int new_x = 0, new_y = 0;
-    unsigned int current_y = this->index_ / num_intersections_x_;
-    unsigned int current_x = this->index_ % num_intersections_x_;
+            // Everyone waiting on the roads that turn green goes at once
+            std::uint64_t next_change;
+            unsigned int phase = this->signal_phase(traffic_event.ts_, next_change);
+            state_.signal_changes_++;
 
-    switch (direction) {
-        case WEST: {
-            new_x = (current_x + num_intersections_x_ - 1) % num_intersections_x_;
-            new_y = current_y;
-        } break;
+            auto kept = state_.waiting_.begin();
+            for (const CarInLane& car : state_.waiting_) {
+                if (signals_.greenPhase(car.lane_ / kNumLanes) == phase) {
+                    this->select_direction(events, traffic_event.ts_, car);
+                    state_.cars_released_++;
+                } else {
+                    *kept++ = car;
+                }
+            }
+            state_.waiting_.erase(kept, state_.waiting_.end());
 
-        case EAST: {
-            new_x = (current_x + 1) % num_intersections_x_;
-            new_y = current_y;
+            // The last change before timestamps run out ends the cycle
+            if (next_change < UINT32_MAX) {
+                events.emplace_back(make_event<TrafficEvent>(this->name_, SIGNAL, 0, 0, 
+                                    NORTH_LEFT, NORTH_LEFT, 0, 0, (unsigned int) next_change));
+            }
         } break;
 
-        case SOUTH: {
-            new_x = current_x;
-            new_y = (current_y + num_intersections_y_ - 1) % num_intersections_y_;
-        } break;
 
-        case NORTH: {
-            new_x = current_x;
-            new_y = (current_y + 1) % num_intersections_y_;
+        case SOURCE: {
+
+            // Every car due by now sets off on a trip from the OD matrix,
+            // entering on a random lane like the cars there at the start, and
+            // is routed to its destination. The next departure is drawn from
+            // when the last car was due, not from the rounded timestamp.
+            UniformIntSampler rand_car_direction(0,11);
+            double due = traffic_event.due_;
+            do {
+                int x_to_go, y_to_go;
+                demand_.drawTrip(index_, *this->rng_, x_to_go, y_to_go);
+                auto lane = (car_direction_t) rand_car_direction(*this->rng_);
+                std::uint64_t car_id = ((std::uint64_t) index_ << 32) | state_.cars_created_++;
+                auto timestamp = traffic_event.ts_ + 
+                                        (unsigned int) std::ceil(interval_expo_(*this->rng_));
+                events.emplace_back(make_event<TrafficEvent>(this->name_, ARRIVAL, x_to_go, 
+                            y_to_go, lane, lane, car_id, traffic_event.ts_, timestamp, true));
+                due = demand_.nextDeparture(due, index_, *this->rng_);
+            } while (due <= traffic_event.ts_);
+            this->schedule_source(events, due);
         } break;
 
         default: {
-            std::cerr << "Invalid move direction " << direction << std::endl;
             assert(0);
         }
     }
-    return lp_name(new_x + new_y * num_intersections_x_);
+    IntersectionProfile::stop(profile, events.size());
+    return events;
 }
 
-int main(int argc, const char** argv) {
-
-    unsigned int num_intersections_x   = 100;
-    unsigned int num_intersections_y   = 100;
-    unsigned int num_cars              = 25;
-    unsigned int mean_interval         = 400;
-
-    TCLAP::ValueArg<unsigned int> num_intersections_x_arg("x", "num-intersections-x", 
-                "Width of intersection grid", false, num_intersections_x, "unsigned int");
-    TCLAP::ValueArg<unsigned int> num_intersections_y_arg("y", "num-intersections-y", 
-                "Height of intersection grid", false, num_intersections_y, "unsigned int");
-    TCLAP::ValueArg<unsigned int> num_cars_arg("n", "number-of-cars", 
-                "Number of cars per intersection", false, num_cars, "unsigned int");
-    TCLAP::ValueArg<unsigned int> mean_interval_arg("i", "mean-interval", 
-                "Mean interval", false, mean_interval, "unsigned int");
-
-    std::vector<TCLAP::Arg*> cmd_line_args = {  &num_intersections_x_arg, 
-                                                &num_intersections_y_arg, 
-                                                &num_cars_arg, 
-                                                &mean_interval_arg  };
-
-    warped::Simulation simulation {"Traffic Simulation", argc, argv, cmd_line_args};
-
-    num_intersections_x = num_intersections_x_arg.getValue();
-    num_intersections_y = num_intersections_y_arg.getValue();
-    num_cars            = num_cars_arg.getValue();
-    mean_interval       = mean_interval_arg.getValue();
-
-    std::vector<Intersection> lps;
-    for (unsigned int index = 0; index < num_intersections_x * num_intersections_y; index++) {
-        lps.emplace_back(   num_intersections_x, 
-                                num_intersections_y, 
-                                num_cars, 
-                                mean_interval, 
-                                index
-                            );
-    }
+std::uint32_t Intersection::choose_road(direction_t side) {
 
-    std::vector<warped::LogicalProcess*> lp_pointers;
-    for (auto& lp : lps) {
-        lp_pointers.push_back(&lp);
+    std::uint32_t num_roads = this->num_side_roads(side);
+    if (num_roads <= 1) {
+        return this->side_road(side, 0);
     }
-    auto status = simulation.simulate(lp_pointers);
+    UniformIntSampler rand_road(0, num_roads - 1);
+    return this->side_road(side, (std::uint32_t) rand_road(*this->rng_));
+}
 
-    unsigned int total_cars_arrived = 0, total_cars_finished = 0;
-    for (auto& lp : lps) {
-        total_cars_arrived  += lp.state_.total_cars_arrived_;
-        total_cars_finished += lp.state_.total_cars_finished_;
+void Intersection::select_direction(std::vector<std::shared_ptr<warped::Event>>& events, 
+                            unsigned int timestamp, const CarInLane& car) {
+
+    const LaneTransition& transition = kLaneTransitions[car.lane_];
+    int to_go[2] = {car.x_to_go_, car.y_to_go_};
+    state_.numIn(car.lane_)--;
+
+    int exit_lane = kStay;
+    if (car.routed_) {
+        exit_lane = this->route_lane(to_go);
+    } else {
+        for (const LaneExit& exit : transition.exits_) {
+            if ((to_go[exit.axis_] * exit.sign_ > 0) && 
+                            (state_.numOut(exit.lane_) < 
+                                side_capacity_[kLaneTransitions[exit.lane_].departure_])) {
+                exit_lane = exit.lane_;
+                to_go[exit.axis_] -= exit.sign_;
+                break;
+            }
+        }
+        if (exit_lane == kStay) {
+            exit_lane = kFallbackLane[car.lane_ / kNumLanes][car.arrived_from_];
+        }
+        if (exit_lane == kStay) {
+            exit_lane = car.lane_;
+        }
     }
-    std::cout << "Total cars arrived  : " << total_cars_arrived  << std::endl;
-    std::cout << "Total cars finished : " << total_cars_finished << std::endl;
 
-    if (simulation.isMasterProcess()) {
-      std::ofstream ofs { "exit_status", std::ios_base::out | std::ios_base::trunc };
-      ofs << static_cast<int>(status);
-    }
+    // Counted even past capacity, as DEPARTURE takes every car off again
+    state_.numOut(exit_lane)++;
 
-    return static_cast<int>(status);
+    timestamp += (unsigned int) std::ceil(interval_expo_(*this->rng_));
+    events.emplace_back(make_event<TrafficEvent>(this->name_, DEPARTURE, to_go[0], to_go[1], 
+                            car.lane_, (car_direction_t) exit_lane, car.car_id_, car.departed_, 
+                            timestamp, car.routed_));
 }
 
+// The road a routed car takes to cut its distance along x (0) or y (1), by
+// whether that distance is positive. Lanes lead towards their road's side.
+constexpr car_direction_t kRouteRoads[2][2] = {
+    {WEST_LEFT, EAST_LEFT},
+    {SOUTH_LEFT, NORTH_LEFT}
+};
+
+car_direction_t Intersection::route_lane(int (&to_go)[2]) {
+
+    // The straight lane of the first road with room, x before y; when every
+    // one is full, the first anyway, like a car that keeps its lane
+    const unsigned int kLaneOrder[kNumLanes] = {1, 0, 2};
+    int chosen_axis = -1;
+    unsigned int chosen_lane = 0;
+    for (unsigned int axis = 0; (axis < 2) && (chosen_axis < 0); axis++) {
+        if (!to_go[axis]) continue;
+        unsigned int road = kRouteRoads[axis][to_go[axis] > 0];
+        for (unsigned int offset : kLaneOrder) {
+            unsigned int lane = road + offset;
+            if (state_.numOut(lane) < side_capacity_[kLaneTransitions[lane].departure_]) {
+                chosen_axis = axis;
+                chosen_lane = lane;
+                break;
+            }
+        }
+    }
+    if (chosen_axis < 0) {
+        chosen_axis = to_go[0] ? 0 : 1;
+        chosen_lane = kRouteRoads[chosen_axis][to_go[chosen_axis] > 0] + 1;
+    }
+    to_go[chosen_axis] -= (to_go[chosen_axis] > 0) ? 1 : -1;
+    return (car_direction_t) chosen_lane;
+}
+
+unsigned int Intersection::signal_phase(unsigned int time, std::uint64_t& next_change) const {
+
+    const std::vector<unsigned int>& green = signals_.green_;
+    std::uint64_t cycle = signals_.cycle();
+    std::uint64_t position = (time + cycle - ((std::uint64_t) index_ * signals_.offset_) % cycle)
+                                    % cycle;
+    unsigned int phase = 0;
+    std::uint64_t phase_end = green[0];
+    while (position >= phase_end) {
+        phase_end += green[++phase];
+    }
+    next_change = time + (phase_end - position);
+    return phase;
+}
@@ -4,73 +4,67 @@
 #ifndef TRAFFIC_HPP_DEFINED
 #define TRAFFIC_HPP_DEFINED
 
+#include <algorithm>
+#include <cmath>
+#include <istream>
 #include <string>
 #include <vector>
 #include <memory>
 #include <random>
 
 #include "warped.hpp"
+#include "cereal/types/vector.hpp"
+#include "utility/event_profile.hpp"
+#include "utility/grid_topology.hpp"
+#include "utility/histogram.hpp"
+#include "utility/lp_names.hpp"
+#include "utility/philox.hpp"
+#include "utility/pod_state.hpp"
+#include "utility/road_network.hpp"
+#include "utility/samplers.hpp"
+#include "utility/trace.hpp"
 
-WARPED_DEFINE_LP_STATE_STRUCT(TrafficState) {
+// Every side of an intersection has a road in and a road out, each with a
+// left, straight and right lane
+const unsigned int kNumRoads = 4;
+const unsigned int kNumLanes = 3;
+
+// Cars each lane of a grid road holds
+const unsigned int kGridRoadCapacity = 5;
+
+// Buckets of the per-intersection trip time histograms
+const unsigned int kTripTimeBuckets = 32;
+typedef FixedHistogram<kTripTimeBuckets> TripTimeHistogram;
+
+struct TrafficCounters {
 
     unsigned int total_cars_arrived_;
     unsigned int total_cars_finished_;
-    unsigned int num_in_north_left_;
-    unsigned int num_in_north_straight_;
-    unsigned int num_in_north_right_;
-    unsigned int num_in_south_left_;
-    unsigned int num_in_south_straight_;
-    unsigned int num_in_south_right_;
-    unsigned int num_in_east_left_;
-    unsigned int num_in_east_straight_;
-    unsigned int num_in_east_right_;
-    unsigned int num_in_west_left_;
-    unsigned int num_in_west_straight_;
-    unsigned int num_in_west_right_;
-    unsigned int num_out_north_left_;
-    unsigned int num_out_north_straight_;
-    unsigned int num_out_north_right_;
-    unsigned int num_out_south_left_;
-    unsigned int num_out_south_straight_;
-    unsigned int num_out_south_right_;
-    unsigned int num_out_east_left_;
-    unsigned int num_out_east_straight_;
-    unsigned int num_out_east_right_;
-    unsigned int num_out_west_left_;
-    unsigned int num_out_west_straight_;
-    unsigned int num_out_west_right_;
+    unsigned int signal_changes_;
+    unsigned int cars_released_;
+    unsigned int cars_created_;
 
-    template <typename Archive>
-    void save(Archive& ar) const {
-      ar(total_cars_arrived_, total_cars_finished_,
-	 num_in_north_left_, num_in_north_straight_, num_in_north_right_,
-	 num_in_south_left_, num_in_south_straight_, num_in_south_right_,
-	 num_in_east_left_, num_in_east_straight_, num_in_east_right_,
-	 num_in_west_left_, num_in_west_straight_, num_in_west_right_,
-	 num_out_north_left_, num_out_north_straight_, num_out_north_right_,
-	 num_out_south_left_, num_out_south_straight_, num_out_south_right_,
-	 num_out_east_left_, num_out_east_straight_, num_out_east_right_,
-	 num_out_west_left_, num_out_west_straight_, num_out_west_right_);
-    }
-    template <typename Archive>
-    void load(Archive& ar) {
-      ar(total_cars_arrived_, total_cars_finished_,
-	 num_in_north_left_, num_in_north_straight_, num_in_north_right_,
-	 num_in_south_left_, num_in_south_straight_, num_in_south_right_,
-	 num_in_east_left_, num_in_east_straight_, num_in_east_right_,
-	 num_in_west_left_, num_in_west_straight_, num_in_west_right_,
-	 num_out_north_left_, num_out_north_straight_, num_out_north_right_,
-	 num_out_south_left_, num_out_south_straight_, num_out_south_right_,
-	 num_out_east_left_, num_out_east_straight_, num_out_east_right_,
-	 num_out_west_left_, num_out_west_straight_, num_out_west_right_);
-    }
+    // Trips that ended here, from the time their car set off
+    std::uint64_t total_trip_time_;
+    TripTimeHistogram trip_times_;
+
+    // Cars on each lane, by road and lane in the order of car_direction_t
+    unsigned int num_in_[kNumRoads][kNumLanes];
+    unsigned int num_out_[kNumRoads][kNumLanes];
+
+    unsigned int& numIn(unsigned int lane) { return num_in_[lane / kNumLanes][lane % kNumLanes]; }
+    unsigned int& numOut(unsigned int lane) { return num_out_[lane / kNumLanes][lane % kNumLanes]; }
 };
 
+WARPED_MODELS_ASSERT_POD_STATE(TrafficCounters);
+
 enum traffic_event_t {
 
     ARRIVAL,
     DEPARTURE,
-    DIRECTION_SELECT
+    DIRECTION_SELECT,
+    SIGNAL,
+    SOURCE
 };
 
 enum car_direction_t {
@@ -91,10 +85,154 @@ enum car_direction_t {
 
 enum direction_t {
 
-    NORTH, 
-    SOUTH, 
-    EAST, 
-    WEST
+    NORTH   = SquareGrid2D::UP, 
+    SOUTH   = SquareGrid2D::DOWN, 
+    EAST    = SquareGrid2D::RIGHT, 
+    WEST    = SquareGrid2D::LEFT
+};
+
+// A car on one of an intersection's incoming lanes. Its id is the index of
+// the intersection it set off from in the upper half and a count of the cars
+// that intersection has set off in the lower.
+struct CarInLane {
+    std::uint64_t car_id_;
+    unsigned int departed_;
+    int x_to_go_;
+    int y_to_go_;
+    car_direction_t arrived_from_;
+    car_direction_t lane_;
+    bool routed_;           // Injected from the OD matrix, see Intersection::route_lane
+
+    WARPED_REGISTER_SERIALIZABLE_MEMBERS(car_id_, departed_, x_to_go_, y_to_go_, 
+                                                            arrived_from_, lane_, routed_)
+};
+
+WARPED_DEFINE_LP_STATE_STRUCT(TrafficState), public TrafficCounters {
+
+    // Cars held at red signals, in order of arrival
+    std::vector<CarInLane> waiting_;
+
+    template <typename Archive>
+    void save(Archive& ar) const {
+      savePodState<TrafficCounters>(ar, *this);
+      ar(waiting_);
+    }
+    template <typename Archive>
+    void load(Archive& ar) {
+      loadPodState<TrafficCounters>(ar, *this);
+      ar(waiting_);
+    }
+};
+
+// Fixed-time signal plan shared by every intersection. The phases give green
+// to the incoming roads in turn: with two phases to north and south, then
+// east and west; with four to north, south, east and west alone. Each
+// intersection starts its cycle 'offset_' later than the one numbered before
+// it, so an offset of the travel time between neighbours makes a green wave
+// along the rows of a grid. A plan without phases has no signals.
+struct TrafficSignalPlan {
+    std::vector<unsigned int> green_;     // Green time of each phase
+    unsigned int offset_ = 0;
+
+    bool enabled() const { return !green_.empty(); }
+
+    std::uint64_t cycle() const {
+        std::uint64_t cycle = 0;
+        for (auto green : green_) cycle += green;
+        return cycle;
+    }
+
+    // The phase in which incoming road 'road' has green
+    unsigned int greenPhase(unsigned int road) const {
+        return road * green_.size() / kNumRoads;
+    }
+};
+
+// Reads the green times of a plan from a comma-separated list, e.g. "30,20".
+// Returns false unless there are two or four, all positive; an empty list
+// means no signals.
+bool parseSignalTimings(const std::string& timings, TrafficSignalPlan& plan);
+
+// Continuous demand on the grid, shared by every intersection. Cars set off
+// from each origin of an origin-destination matrix as a Poisson process whose
+// rate is the sum of the origin's row, scaled by a piecewise-constant
+// time-of-day profile that repeats every day. Each car is given the x and y
+// distances, the shorter way round the torus, to a destination drawn from the
+// row in proportion to its rate, east and north being positive. A demand
+// without trips injects no cars.
+class TrafficDemand {
+public:
+    struct ProfileStep {
+        unsigned int start_;    // Time of day the step begins
+        double factor_;
+    };
+
+    // Reads "origin destination rate" lines, intersections numbered row-major
+    // on a size_x by size_y grid and rates in cars per unit of simulation time.
+    // '#' starts a comment. Returns false with 'error' set if the file is
+    // missing or invalid.
+    bool loadMatrix(const std::string& filename, unsigned int size_x, unsigned int size_y, 
+                                                                    std::string& error);
+
+    // The same from 'input', whose lines 'name' labels in errors
+    bool loadMatrix(std::istream& input, const std::string& name, unsigned int size_x, 
+                                                unsigned int size_y, std::string& error);
+
+    // Reads the profile from comma-separated "start:factor" steps with
+    // increasing starts, the first at 0, e.g. "0:0.2,25200:2.5,32400:1". An
+    // empty profile keeps every rate at its matrix value.
+    bool setProfile(const std::string& profile, unsigned int day_length, std::string& error);
+
+    bool enabled() const { return !rows_.empty(); }
+
+    // Cars per unit of time from 'origin' at a factor of 1
+    double rate(std::uint32_t origin) const {
+        std::int64_t row = (origin < row_of_.size()) ? row_of_[origin] : -1;
+        return (row < 0) ? 0.0 : rows_[row].rate_;
+    }
+
+    // When the next car after 'time' sets off from 'origin', which must have
+    // a positive rate; UINT32_MAX or later if none does before the end of
+    // time. Times are not rounded, so that drawing each departure from the
+    // one before keeps to the rate.
+    template <typename URNG>
+    double nextDeparture(double time, std::uint32_t origin, URNG& rng) const {
+        return departureAfter(time, rate(origin), unit_expo_(rng));
+    }
+
+    // Draws the destination of a car from 'origin' and the distances to it
+    template <typename URNG>
+    void drawTrip(std::uint32_t origin, URNG& rng, int& x_to_go, int& y_to_go) const {
+        const Row& row = rows_[row_of_[origin]];
+        std::uint32_t destination = row.destinations_[row.table_.sample(rng)];
+        x_to_go = torusDistance(origin % size_x_, destination % size_x_, size_x_);
+        y_to_go = torusDistance(origin / size_x_, destination / size_x_, size_y_);
+    }
+
+private:
+    struct Row {
+        double rate_;
+        std::vector<std::uint32_t> destinations_;
+        sampler_detail::AliasTable table_;
+    };
+
+    // The time at which the profile-scaled rate integrates to 'work' from 'time'
+    double departureAfter(double time, double rate, double work) const;
+
+    static int torusDistance(unsigned int from, unsigned int to, unsigned int size) {
+        int distance = (int) to - (int) from;
+        if (2 * distance > (int) size) distance -= size;
+        if (2 * distance <= -(int) size) distance += size;
+        return distance;
+    }
+
+    unsigned int size_x_ = 0;
+    unsigned int size_y_ = 0;
+    std::vector<std::int64_t> row_of_;
+    std::vector<Row> rows_;
+    std::vector<ProfileStep> profile_ {ProfileStep {0, 1.0}};
+    unsigned int day_length_ = 0;
+    ExponentialSampler unit_expo_ {1.0};
 };
 
 class TrafficEvent : public warped::Event {
@@ -106,14 +244,22 @@ public:
                     const int y_to_go, 
                     const car_direction_t arrived_from, 
                     const car_direction_t current_lane, 
-                    const unsigned int timestamp    )
+                    const std::uint64_t car_id, 
+                    const unsigned int departed, 
+                    const unsigned int timestamp, 
+                    const bool routed = false, 
+                    const double due = 0.0  )
             :   receiver_name_(receiver_name), 
                 type_(type), 
                 x_to_go_(x_to_go),
                 y_to_go_(y_to_go),
                 arrived_from_(arrived_from),
                 current_lane_(current_lane),
-                ts_(timestamp)  {}
+                routed_(routed),
+                car_id_(car_id),
+                departed_(departed),
+                ts_(timestamp), 
+                due_(due)   {}
 
     const std::string& receiverName() const { return receiver_name_; }
     unsigned int timestamp() const { return ts_; }
@@ -124,74 +270,111 @@ public:
 	int y_to_go_;
 	car_direction_t arrived_from_;
 	car_direction_t current_lane_;
+    bool routed_;
+    std::uint64_t car_id_;
+    unsigned int departed_;     // When the car set off
     unsigned int ts_;
+    double due_;                // SOURCE: when its first car is due, before rounding up to ts_
 
     WARPED_REGISTER_SERIALIZABLE_MEMBERS(
                     cereal::base_class<warped::Event>(this), receiver_name_, 
-                    type_, x_to_go_, y_to_go_, arrived_from_, current_lane_, ts_)
+                    type_, x_to_go_, y_to_go_, arrived_from_, current_lane_, 
+                    routed_, car_id_, departed_, ts_, due_)
 };
 
 class Intersection : public warped::LogicalProcess {
 public:
-    Intersection(   const unsigned int num_intersections_x,
-                    const unsigned int num_intersections_y,
+    Intersection(   const LPNameRegistry& lp_names,
+                    const RoadNetwork& network,
+                    const TrafficSignalPlan& signals,
+                    const TrafficDemand& demand,
                     const unsigned int num_cars,
                     const unsigned int mean_interval,
+                    const unsigned int trip_bucket_width,
+                    const std::uint64_t seed,
                     const unsigned int index    )
-            :   LogicalProcess(lp_name(index)),
+            :   LogicalProcess(lp_names[index]),
                 state_(),
-                rng_(new std::default_random_engine(index)),
-                num_intersections_x_(num_intersections_x),
-                num_intersections_y_(num_intersections_y),
+                lp_names_(lp_names),
+                rng_(new Philox4x32(seed, index)),
+                network_(network),
+                signals_(signals),
+                demand_(demand),
                 num_cars_(num_cars),
-                mean_interval_(mean_interval),
+                interval_expo_(mean_interval),
+                trip_bucket_width_(trip_bucket_width),
                 index_(index)       {
 
-         state_.total_cars_arrived_ = 0;
-         state_.total_cars_finished_ = 0;
-         state_.num_in_north_left_ = 0;
-         state_.num_in_north_straight_ = 0;
-         state_.num_in_north_right_ = 0;
-         state_.num_in_south_left_ = 0;
-         state_.num_in_south_straight_ = 0;
-         state_.num_in_south_right_ = 0;
-         state_.num_in_east_left_ = 0;
-         state_.num_in_east_straight_ = 0;
-         state_.num_in_east_right_ = 0;
-         state_.num_in_west_left_ = 0;
-         state_.num_in_west_straight_ = 0;
-         state_.num_in_west_right_ = 0;
-         state_.num_out_north_left_ = 0;
-         state_.num_out_north_straight_ = 0;
-         state_.num_out_north_right_ = 0;
-         state_.num_out_south_left_ = 0;
-         state_.num_out_south_straight_ = 0;
-         state_.num_out_south_right_ = 0;
-         state_.num_out_east_left_ = 0;
-         state_.num_out_east_straight_ = 0;
-         state_.num_out_east_right_ = 0;
-         state_.num_out_west_left_ = 0;
-         state_.num_out_west_straight_ = 0;
-         state_.num_out_west_right_ = 0;
+        static_cast<TrafficCounters&>(state_) = TrafficCounters();
+        state_.cars_created_ = num_cars;
+        for (unsigned int side = 0; side < kNumRoads; side++) {
+            side_capacity_[side] = 0;
+            for (std::uint32_t i = 0; i < num_side_roads((direction_t) side); i++) {
+                side_capacity_[side] += network_.capacity(side_road((direction_t) side, i));
+            }
+        }
     }
 
     virtual std::vector<std::shared_ptr<warped::Event>> initializeLP() override;
     virtual std::vector<std::shared_ptr<warped::Event>> receiveEvent(const warped::Event&);
     virtual warped::LPState& getState() { return this->state_; }
 
-    TrafficState state_;
+    // Records every processed event to 'trace' from now on
+    void recordTo(TraceWriter* trace) { trace_ = trace; }
 
-    static inline std::string lp_name(const unsigned int);
+    TrafficState state_;
 
 protected:
-    std::shared_ptr<std::default_random_engine> rng_;
-    const unsigned int num_intersections_x_;
-    const unsigned int num_intersections_y_;
+    const LPNameRegistry& lp_names_;
+    std::shared_ptr<Philox4x32> rng_;
+    const RoadNetwork& network_;
+    const TrafficSignalPlan& signals_;
+    const TrafficDemand& demand_;
     const unsigned int num_cars_;
-    const unsigned int mean_interval_;
+    const ExponentialSampler interval_expo_;
+    const unsigned int trip_bucket_width_;
     const unsigned int index_;
+    TraceWriter* trace_ = nullptr;
 
-    std::string compute_move(direction_t direction);
+    // Cars each lane towards a side holds, summed over the side's roads
+    unsigned int side_capacity_[kNumRoads];
+
+    // The intersection's roads are dealt out to the sides in turn, so that
+    // road i of the node leads towards side i % 4. At a node with fewer than
+    // four roads, side s takes road s % degree; at a dead end there are none.
+    std::uint32_t num_side_roads(direction_t side) const {
+        std::uint32_t degree = network_.degree(index_);
+        return (degree >= kNumRoads) ? (degree - side + kNumRoads - 1) / kNumRoads : (degree > 0);
+    }
+    std::uint32_t side_road(direction_t side, std::uint32_t i) const {
+        std::uint32_t degree = network_.degree(index_);
+        return network_.firstRoad(index_) + 
+                        ((degree >= kNumRoads) ? side + i * kNumRoads : side % degree);
+    }
+
+    // One of the roads towards 'side', at random if there are several
+    std::uint32_t choose_road(direction_t side);
+
+    // Moves a car from its incoming lane to the outgoing lane it picks and
+    // sends its DEPARTURE
+    void select_direction(std::vector<std::shared_ptr<warped::Event>>& events, 
+                            unsigned int timestamp, const CarInLane& car);
+
+    // The outgoing lane of a routed car, on a road that takes it a step
+    // closer to its destination, and that step taken off 'to_go'
+    car_direction_t route_lane(int (&to_go)[2]);
+
+    // Sends the SOURCE event that injects the car due to set off at 'due',
+    // unless that is past the last timestamp an event can have
+    void schedule_source(std::vector<std::shared_ptr<warped::Event>>& events, double due);
+
+    // The signal phase at 'time', and when it next changes, which may be past
+    // the last timestamp an event can have
+    unsigned int signal_phase(unsigned int time, std::uint64_t& next_change) const;
 };
 
+typedef EventProfile<Intersection, 5> IntersectionProfile;
+const char* const kTrafficEventNames[] = {"ARRIVAL", "DEPARTURE", "DIRECTION_SELECT", "SIGNAL", 
+                                                                                    "SOURCE"};
+
 #endif
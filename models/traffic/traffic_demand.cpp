@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "traffic.hpp"
+
+bool TrafficDemand::loadMatrix(const std::string& filename, unsigned int size_x,
+                                            unsigned int size_y, std::string& error) {
+
+    std::ifstream input(filename);
+    if (!input) {
+        error = "could not open " + filename;
+        return false;
+    }
+    return loadMatrix(input, filename, size_x, size_y, error);
+}
+
+bool TrafficDemand::loadMatrix(std::istream& input, const std::string& name,
+                        unsigned int size_x, unsigned int size_y, std::string& error) {
+
+    size_x_ = size_x;
+    size_y_ = size_y;
+    std::uint32_t num_intersections = size_x * size_y;
+    std::vector<std::vector<std::pair<std::uint32_t, double> > > trips(num_intersections);
+    std::string line;
+    for (unsigned long line_number = 1; std::getline(input, line); line_number++) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        std::string first;
+        if (!(fields >> first)) continue;
+
+        fields.str(line.substr(0, line.find('#')));
+        fields.clear();
+        std::uint32_t origin, destination;
+        double rate;
+        std::string rest;
+        std::string where = name + ":" + std::to_string(line_number) + ": ";
+        if (!(fields >> origin >> destination >> rate) || (fields >> rest)) {
+            error = where + "expected \"origin destination rate\"";
+            return false;
+        }
+        if ((origin >= num_intersections) || (destination >= num_intersections)) {
+            error = where + "no intersection " +
+                        std::to_string(std::max(origin, destination)) + " on the grid";
+            return false;
+        }
+        if (!(rate >= 0.0) || !std::isfinite(rate)) {
+            error = where + "rate must not be negative";
+            return false;
+        }
+        if (rate > 0.0) {
+            trips[origin].emplace_back(destination, rate);
+        }
+    }
+
+    row_of_.assign(num_intersections, -1);
+    rows_.clear();
+    for (std::uint32_t origin = 0; origin < num_intersections; origin++) {
+        if (trips[origin].empty()) continue;
+
+        double total = 0.0;
+        std::vector<std::uint32_t> destinations;
+        std::vector<double> weights;
+        for (auto& trip : trips[origin]) {
+            destinations.push_back(trip.first);
+            weights.push_back(trip.second);
+            total += trip.second;
+        }
+        row_of_[origin] = rows_.size();
+        rows_.push_back(Row {total, std::move(destinations), sampler_detail::AliasTable(weights)});
+    }
+    if (rows_.empty()) {
+        error = name + " has no trips";
+        return false;
+    }
+    return true;
+}
+
+bool TrafficDemand::setProfile(const std::string& profile, unsigned int day_length,
+                                                                    std::string& error) {
+
+    std::vector<ProfileStep> steps;
+    bool busy = false;
+    std::istringstream list(profile);
+    std::string step;
+    while (std::getline(list, step, ',')) {
+        std::string::size_type colon = step.find(':');
+        unsigned long start = 0;
+        double factor = -1.0;
+        std::size_t start_digits = 0, factor_digits = 0;
+        try {
+            start = std::stoul(step.substr(0, colon), &start_digits);
+            factor = std::stod(step.substr(colon + 1), &factor_digits);
+        } catch (const std::exception&) {}
+        if ((colon == std::string::npos) || (start_digits != colon) ||
+                        !factor_digits || (colon + 1 + factor_digits != step.size())) {
+            error = "profile step \"start:factor\" expected, not " + step;
+            return false;
+        }
+        if (!(factor >= 0.0) || !std::isfinite(factor)) {
+            error = "factor of the step at " + std::to_string(start) + " must not be negative";
+            return false;
+        }
+        if (steps.empty() ? (start != 0) : (start <= steps.back().start_)) {
+            error = "profile steps must start at 0 and in increasing order";
+            return false;
+        }
+        if (start >= day_length) {
+            error = "profile step at " + std::to_string(start) + " is not within the day";
+            return false;
+        }
+        steps.push_back(ProfileStep {(unsigned int) start, factor});
+        busy = busy || (factor > 0.0);
+    }
+
+    if (steps.empty()) {
+        profile_.assign(1, ProfileStep {0, 1.0});
+        day_length_ = 0;
+        return true;
+    }
+    if (!busy) {
+        error = "a profile needs a step with a positive factor";
+        return false;
+    }
+    profile_ = std::move(steps);
+    day_length_ = day_length;
+    return true;
+}
+
+double TrafficDemand::departureAfter(double time, double rate, double work) const {
+
+    if (!day_length_) {
+        return time + work / rate;
+    }
+
+    // Walk through the steps from 'time', skipping whole days in one go once
+    // the rest of the current one is used up
+    double day_work = 0.0;
+    for (unsigned int i = 0; i < profile_.size(); i++) {
+        unsigned int end = (i + 1 < profile_.size()) ? profile_[i + 1].start_ : day_length_;
+        day_work += rate * profile_[i].factor_ * (end - profile_[i].start_);
+    }
+    double day_start = std::floor(time / day_length_) * day_length_;
+    double position = time - day_start;
+    while (day_start < UINT32_MAX) {
+        for (unsigned int i = 0; i < profile_.size(); i++) {
+            unsigned int end = (i + 1 < profile_.size()) ? profile_[i + 1].start_ : day_length_;
+            if (end <= position) continue;
+            double step_rate = rate * profile_[i].factor_;
+            double step_work = step_rate * (end - position);
+            if ((step_rate > 0.0) && (work <= step_work)) {
+                return day_start + position + work / step_rate;
+            }
+            work -= step_work;
+            position = end;
+        }
+        double whole_days = std::floor(work / day_work);
+        work -= whole_days * day_work;
+        day_start += (whole_days + 1) * day_length_;
+        position = 0.0;
+    }
+    return UINT32_MAX;
+}
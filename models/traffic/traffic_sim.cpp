@@ -0,0 +1,292 @@
+// Ported from the ROSS traffic model 
+// https://github.com/carothersc/ROSS-Models/blob/master/traffic/
+
+#include <fstream>
+#include "traffic.hpp"
+#include "utility/results.hpp"
+#include "tclap/ValueArg.h"
+
+int main(int argc, const char** argv) {
+
+    unsigned int num_intersections_x   = 100;
+    unsigned int num_intersections_y   = 100;
+    unsigned int num_cars              = 25;
+    unsigned int mean_interval         = 400;
+    unsigned long seed                 = 0;
+    std::string results_filename       = "";
+    std::string trace_filename         = "";
+    std::string network_filename       = "";
+    std::string signal_timings         = "";
+    unsigned int signal_offset         = 0;
+    unsigned int trip_bucket_width     = 10000;
+    std::string trip_histogram_filename = "";
+    std::string od_matrix_filename     = "";
+    std::string demand_profile         = "";
+    unsigned int day_length            = 86400;
+
+    TCLAP::ValueArg<unsigned int> num_intersections_x_arg("x", "num-intersections-x", 
+                "Width of intersection grid", false, num_intersections_x, "unsigned int");
+    TCLAP::ValueArg<unsigned int> num_intersections_y_arg("y", "num-intersections-y", 
+                "Height of intersection grid", false, num_intersections_y, "unsigned int");
+    TCLAP::ValueArg<unsigned int> num_cars_arg("n", "number-of-cars", 
+                "Number of cars per intersection", false, num_cars, "unsigned int");
+    TCLAP::ValueArg<unsigned int> mean_interval_arg("i", "mean-interval", 
+                "Mean interval", false, mean_interval, "unsigned int");
+    TCLAP::ValueArg<unsigned long> seed_arg("", "seed", 
+                "Global seed of the per-intersection random streams", false, seed, "unsigned long");
+    TCLAP::ValueArg<std::string> results_arg("", "results", 
+                "Columnar binary file to write each intersection's final state to", 
+                                                        false, results_filename, "string");
+    TCLAP::ValueArg<std::string> trace_arg("", "trace", 
+                "Binary file to record every processed event to", false, trace_filename, "string");
+    TCLAP::ValueArg<std::string> network_arg("", "road-network", 
+                "Binary road network file to use instead of the grid, see road_network_convert", 
+                                                        false, network_filename, "string");
+    TCLAP::ValueArg<std::string> signal_timings_arg("", "signal-timings", 
+                "Comma-separated green times of the signal phases, two (north and south, east "
+                "and west) or four (north, south, east, west); none for no signals", 
+                                                        false, signal_timings, "string");
+    TCLAP::ValueArg<unsigned int> signal_offset_arg("", "signal-offset", 
+                "Delay of each intersection's signal cycle after the one numbered before it", 
+                                                        false, signal_offset, "unsigned int");
+    TCLAP::ValueArg<unsigned int> trip_bucket_arg("", "trip-bucket", 
+                "Width of the trip time histogram buckets", false, trip_bucket_width, 
+                                                                            "unsigned int");
+    TCLAP::ValueArg<std::string> trip_histogram_arg("", "trip-histogram", 
+                "CSV file to write the merged trip time histogram to", 
+                                                false, trip_histogram_filename, "string");
+    TCLAP::ValueArg<std::string> od_matrix_arg("", "od-matrix", 
+                "Text file of \"origin destination rate\" lines to inject cars from while "
+                "the simulation runs, see README", false, od_matrix_filename, "string");
+    TCLAP::ValueArg<std::string> demand_profile_arg("", "demand-profile", 
+                "Comma-separated \"start:factor\" steps scaling the OD matrix rates over "
+                "each day, e.g. 0:0.2,25200:2.5,32400:1", false, demand_profile, "string");
+    TCLAP::ValueArg<unsigned int> day_length_arg("", "day-length", 
+                "Length of the day the demand profile repeats over", false, day_length, 
+                                                                            "unsigned int");
+
+    std::vector<TCLAP::Arg*> cmd_line_args = {  &num_intersections_x_arg, 
+                                                &num_intersections_y_arg, 
+                                                &num_cars_arg, 
+                                                &mean_interval_arg, 
+                                                &seed_arg, 
+                                                &results_arg, 
+                                                &trace_arg, 
+                                                &network_arg, 
+                                                &signal_timings_arg, 
+                                                &signal_offset_arg, 
+                                                &trip_bucket_arg, 
+                                                &trip_histogram_arg, 
+                                                &od_matrix_arg, 
+                                                &demand_profile_arg, 
+                                                &day_length_arg };
+
+    warped::Simulation simulation {"Traffic Simulation", argc, argv, cmd_line_args};
+
+    num_intersections_x = num_intersections_x_arg.getValue();
+    num_intersections_y = num_intersections_y_arg.getValue();
+    num_cars            = num_cars_arg.getValue();
+    mean_interval       = mean_interval_arg.getValue();
+    seed                = seed_arg.getValue();
+    results_filename    = results_arg.getValue();
+    trace_filename      = trace_arg.getValue();
+    network_filename    = network_arg.getValue();
+    signal_timings      = signal_timings_arg.getValue();
+    signal_offset       = signal_offset_arg.getValue();
+    trip_bucket_width   = trip_bucket_arg.getValue();
+    trip_histogram_filename = trip_histogram_arg.getValue();
+    od_matrix_filename  = od_matrix_arg.getValue();
+    demand_profile      = demand_profile_arg.getValue();
+    day_length          = day_length_arg.getValue();
+
+    if (!trip_bucket_width) {
+        std::cerr << "The trip time bucket width must be positive" << std::endl;
+        return 1;
+    }
+
+    TrafficSignalPlan signals;
+    if (!parseSignalTimings(signal_timings, signals)) {
+        std::cerr << "Signal timings must be two or four positive green times, not "
+                                                            << signal_timings << std::endl;
+        return 1;
+    }
+    signals.offset_ = signal_offset;
+
+    RoadNetwork network;
+    if (network_filename.empty()) {
+        Torus2D grid {num_intersections_x, num_intersections_y};
+        network = RoadNetwork::fromGrid(grid, 0, kGridRoadCapacity);
+    } else if (!network.open(network_filename)) {
+        std::cerr << "Invalid road network file - " << network_filename << std::endl;
+        return 1;
+    }
+    unsigned int num_intersections = network.numNodes();
+
+    // Injected cars are given their trips as x and y distances, which only
+    // the grid has
+    TrafficDemand demand;
+    std::string demand_error;
+    if (!od_matrix_filename.empty() && !network_filename.empty()) {
+        std::cerr << "An OD matrix can only be used on the grid, not a road network" << std::endl;
+        return 1;
+    }
+    if ((!od_matrix_filename.empty() && !demand.loadMatrix(od_matrix_filename, 
+                            num_intersections_x, num_intersections_y, demand_error)) || 
+                !demand.setProfile(demand_profile, day_length, demand_error)) {
+        std::cerr << "Invalid demand: " << demand_error << std::endl;
+        return 1;
+    }
+
+    LPNameRegistry lp_names {"Intersection_", num_intersections};
+
+    std::vector<Intersection> lps;
+    for (unsigned int index = 0; index < num_intersections; index++) {
+        lps.emplace_back(   lp_names,
+                                network, 
+                                signals, 
+                                demand, 
+                                num_cars, 
+                                mean_interval, 
+                                trip_bucket_width, 
+                                seed, 
+                                index
+                            );
+    }
+
+    TraceWriter trace;
+    if (!trace_filename.empty()) {
+        if (!trace.open(trace_filename, "traffic", {
+                {"num-intersections-x", std::to_string(num_intersections_x)},
+                {"num-intersections-y", std::to_string(num_intersections_y)},
+                {"number-of-cars", std::to_string(num_cars)},
+                {"mean-interval", std::to_string(mean_interval)},
+                {"trip-bucket", std::to_string(trip_bucket_width)},
+                {"seed", std::to_string(seed)},
+                {"road-network", network_filename},
+                {"signal-timings", signal_timings},
+                {"signal-offset", std::to_string(signal_offset)},
+                {"od-matrix", od_matrix_filename},
+                {"demand-profile", demand_profile},
+                {"day-length", std::to_string(day_length)}})) {
+            std::cerr << "Could not create trace file - " << trace_filename << std::endl;
+            return 1;
+        }
+        for (auto& lp : lps) {
+            lp.recordTo(&trace);
+        }
+    }
+
+    std::vector<warped::LogicalProcess*> lp_pointers;
+    for (auto& lp : lps) {
+        lp_pointers.push_back(&lp);
+    }
+    auto status = simulation.simulate(lp_pointers);
+    IntersectionProfile::report("traffic", kTrafficEventNames);
+
+    if (trace.isOpen()) {
+        std::uint64_t dropped = trace.numDropped();
+        if (!trace.close() || dropped) {
+            std::cerr << "Trace file " << trace_filename << " is incomplete, " 
+                                    << dropped << " events not recorded" << std::endl;
+        }
+    }
+
+    unsigned int total_cars_arrived = 0, total_cars_finished = 0;
+    for (auto& lp : lps) {
+        total_cars_arrived  += lp.state_.total_cars_arrived_;
+        total_cars_finished += lp.state_.total_cars_finished_;
+    }
+    std::cout << "Total cars arrived  : " << total_cars_arrived  << std::endl;
+    std::cout << "Total cars finished : " << total_cars_finished << std::endl;
+    if (demand.enabled()) {
+        std::uint64_t cars_injected = 0;
+        for (auto& lp : lps) {
+            cars_injected += lp.state_.cars_created_ - num_cars;
+        }
+        std::cout << "Cars injected       : " << cars_injected << std::endl;
+    }
+
+    // Trip times, merged from every intersection's histogram
+    FixedHistogram<kTripTimeBuckets, std::uint64_t> trip_times {};
+    std::uint64_t total_trip_time = 0;
+    for (auto& lp : lps) {
+        trip_times.merge(lp.state_.trip_times_);
+        total_trip_time += lp.state_.total_trip_time_;
+    }
+    if (trip_times.total()) {
+        std::cout << "Trip times          : mean " << total_trip_time / total_cars_finished 
+                  << ", p50 <= " << trip_times.quantile(0.50, trip_bucket_width) 
+                  << ", p90 <= " << trip_times.quantile(0.90, trip_bucket_width) 
+                  << ", p99 <= " << trip_times.quantile(0.99, trip_bucket_width) 
+                  << ", " << trip_times.counts_[kTripTimeBuckets - 1] << " over " 
+                  << (kTripTimeBuckets - 1) * trip_bucket_width << std::endl;
+    }
+    if (trip_times.total() < total_cars_finished) {
+        std::cerr << "Trip time histogram is missing " << total_cars_finished - trip_times.total() 
+                  << " trips that found their intersection's bucket full" << std::endl;
+    }
+    if (simulation.isMasterProcess() && !trip_histogram_filename.empty()) {
+        std::ofstream histogram {trip_histogram_filename};
+        histogram << "from,to,trips" << std::endl;
+        for (unsigned int bucket = 0; bucket < kTripTimeBuckets; bucket++) {
+            histogram << bucket * trip_bucket_width << ",";
+            if (bucket < kTripTimeBuckets - 1) {
+                histogram << (bucket + 1) * trip_bucket_width;
+            }
+            histogram << "," << trip_times.counts_[bucket] << std::endl;
+        }
+        if (!histogram) {
+            std::cerr << "Could not write trip histogram - " << trip_histogram_filename << std::endl;
+        }
+    }
+    if (signals.enabled()) {
+        unsigned int signal_changes = 0, cars_released = 0;
+        for (auto& lp : lps) {
+            signal_changes += lp.state_.signal_changes_;
+            cars_released  += lp.state_.cars_released_;
+        }
+        std::cout << "Signal changes      : " << signal_changes << ", " << cars_released 
+                  << " cars released, " << (signal_changes ? (double) cars_released / 
+                                                signal_changes : 0.0) << " per change" << std::endl;
+    }
+
+    if (simulation.isMasterProcess() && !results_filename.empty()) {
+        const char* const road_names[kNumRoads] = {"north", "south", "east", "west"};
+        const char* const lane_names[kNumLanes] = {"left", "straight", "right"};
+
+        ResultsWriter results {lps.size()};
+        results.addColumn<std::uint32_t>("total_cars_arrived", 
+                    [&](std::uint64_t i) { return lps[i].state_.total_cars_arrived_; });
+        results.addColumn<std::uint32_t>("total_cars_finished", 
+                    [&](std::uint64_t i) { return lps[i].state_.total_cars_finished_; });
+        for (unsigned int lane = 0; lane < kNumRoads * kNumLanes; lane++) {
+            results.addColumn<std::uint32_t>(std::string("num_in_") + road_names[lane / kNumLanes] 
+                        + "_" + lane_names[lane % kNumLanes], 
+                        [&](std::uint64_t i) { return lps[i].state_.numIn(lane); });
+        }
+        for (unsigned int lane = 0; lane < kNumRoads * kNumLanes; lane++) {
+            results.addColumn<std::uint32_t>(std::string("num_out_") + road_names[lane / kNumLanes] 
+                        + "_" + lane_names[lane % kNumLanes], 
+                        [&](std::uint64_t i) { return lps[i].state_.numOut(lane); });
+        }
+        if (signals.enabled()) {
+            results.addColumn<std::uint32_t>("signal_changes", 
+                        [&](std::uint64_t i) { return lps[i].state_.signal_changes_; });
+            results.addColumn<std::uint32_t>("cars_released", 
+                        [&](std::uint64_t i) { return lps[i].state_.cars_released_; });
+            results.addColumn<std::uint32_t>("cars_waiting", 
+                        [&](std::uint64_t i) { return lps[i].state_.waiting_.size(); });
+        }
+        if (!results.write(results_filename)) {
+            std::cerr << "Could not write results file - " << results_filename << std::endl;
+        }
+    }
+
+    if (simulation.isMasterProcess()) {
+      std::ofstream ofs { "exit_status", std::ios_base::out | std::ios_base::trunc };
+      ofs << static_cast<int>(status);
+    }
+
+    return static_cast<int>(status);
+}
+
@@ -0,0 +1,62 @@
+// Converts a per-LP results file written by a model's --results option to
+// CSV on standard output, one row per LP preceded by its index.
+//
+//   results_to_csv airport_results.bin > airport_results.csv
+
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+
+#include "utility/results.hpp"
+
+int main(int argc, const char** argv) {
+
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <results file>" << std::endl;
+        return 1;
+    }
+
+    ResultsReader results;
+    if (!results.read(argv[1])) {
+        std::cerr << "Invalid results file - " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::printf("lp");
+    for (auto& column : results.columns()) {
+        std::printf(",%s", column.name_.c_str());
+    }
+    std::printf("\n");
+
+    for (std::uint64_t row = 0; row < results.numRows(); row++) {
+        std::printf("%" PRIu64, row);
+        for (auto& column : results.columns()) {
+            switch (column.type_) {
+                case ResultColumnType::UINT32:
+                    std::printf(",%" PRIu32, results.value<std::uint32_t>(column, row));
+                    break;
+                case ResultColumnType::UINT64:
+                    std::printf(",%" PRIu64, results.value<std::uint64_t>(column, row));
+                    break;
+                case ResultColumnType::INT64:
+                    std::printf(",%" PRId64, results.value<std::int64_t>(column, row));
+                    break;
+                case ResultColumnType::FLOAT64:
+                    std::printf(",%.17g", results.value<double>(column, row));
+                    break;
+                case ResultColumnType::STRING: {
+                    // Quote names, doubling any embedded quotes
+                    std::string value = results.stringValue(column, row);
+                    std::printf(",\"");
+                    for (char c : value) {
+                        if (c == '"') std::putchar('"');
+                        std::putchar(c);
+                    }
+                    std::printf("\"");
+                } break;
+            }
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
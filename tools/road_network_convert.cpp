@@ -0,0 +1,107 @@
+// Converts a text edge list to the binary road network read by the traffic
+// model's --road-network option.
+//
+//   road_network_convert city_roads.txt city_roads.bin
+//
+// Each line is one directed road, "from to length capacity", where from and
+// to are node numbers, length is in simulation time units and capacity is
+// the cars each lane of the road holds. Blank lines and lines starting with
+// '#' are skipped. Node numbers need not be contiguous: they are renumbered
+// 0, 1, ... in increasing order, which leaves an already dense numbering
+// unchanged. A two-way street is two lines.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "utility/road_network.hpp"
+
+int main(int argc, const char** argv) {
+
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <edge list> <road network file>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(argv[1]);
+    if (!input) {
+        std::cerr << "Could not open edge list - " << argv[1] << std::endl;
+        return 1;
+    }
+
+    struct Edge {
+        std::uint64_t from_;
+        std::uint64_t to_;
+        std::uint32_t length_;
+        std::uint32_t capacity_;
+    };
+    std::vector<Edge> edges;
+    std::string line;
+    for (unsigned long line_number = 1; std::getline(input, line); line_number++) {
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first) || (first[0] == '#')) continue;
+
+        fields.str(line);
+        fields.clear();
+        Edge edge;
+        std::string rest;
+        if (!(fields >> edge.from_ >> edge.to_ >> edge.length_ >> edge.capacity_) ||
+                                                                        (fields >> rest)) {
+            std::cerr << argv[1] << ":" << line_number
+                      << ": expected \"from to length capacity\"" << std::endl;
+            return 1;
+        }
+        edges.push_back(edge);
+    }
+
+    std::vector<std::uint64_t> nodes;
+    nodes.reserve(2 * edges.size());
+    for (auto& edge : edges) {
+        nodes.push_back(edge.from_);
+        nodes.push_back(edge.to_);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    if ((nodes.size() >= UINT32_MAX) || (edges.size() >= UINT32_MAX)) {
+        std::cerr << "Too many nodes or roads for a road network file" << std::endl;
+        return 1;
+    }
+
+    auto number = [&](std::uint64_t node) {
+        return (std::uint32_t) (std::lower_bound(nodes.begin(), nodes.end(), node) - nodes.begin());
+    };
+    std::vector<RoadNetwork::Road> roads;
+    roads.reserve(edges.size());
+    for (auto& edge : edges) {
+        roads.push_back(RoadNetwork::Road {number(edge.from_), number(edge.to_),
+                                                        edge.length_, edge.capacity_});
+    }
+
+    RoadNetwork network = RoadNetwork::fromRoads(nodes.size(), roads);
+    if (!network.write(argv[2])) {
+        std::cerr << "Could not write road network file - " << argv[2] << std::endl;
+        return 1;
+    }
+
+    // The degree spread is what sets a city apart from a grid
+    std::vector<std::uint32_t> degrees(network.numNodes());
+    std::uint32_t dead_ends = 0;
+    for (std::uint32_t node = 0; node < network.numNodes(); node++) {
+        degrees[node] = network.degree(node);
+        dead_ends += (degrees[node] == 0);
+    }
+    std::sort(degrees.begin(), degrees.end());
+    std::printf("%" PRIu32 " nodes, %" PRIu32 " roads\n", network.numNodes(), network.numRoads());
+    if (!degrees.empty()) {
+        std::printf("out-degree: median %" PRIu32 ", 99th percentile %" PRIu32 ", max %" PRIu32
+                        ", %" PRIu32 " dead ends\n", degrees[degrees.size() / 2],
+                        degrees[degrees.size() * 99 / 100], degrees.back(), dead_ends);
+    }
+    return 0;
+}